@@ -1,11 +1,16 @@
 #ifndef LANG_UTILS_ITERATOR_H
 #define LANG_UTILS_ITERATOR_H
 
+#include <atomic>
 #include <iterator>
 #include <type_traits>
 #include <cassert>
 #include <memory>
 #include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace lang_utils {
 
@@ -180,6 +185,129 @@ private:
     std::function<iterator()> m_get_end;
 };
 
+// A dynamic_collection that can be repointed while other threads iterate
+// it. set() publishes the new source with an atomic swap and readers never
+// lock: read() pins the current source and returns a snapshot whose
+// begin() and end() always refer to the same backing collection. The
+// retired source is freed once every reader that could have seen it has
+// dropped its snapshot, tracked with per thread striped reader counts in
+// two alternating epochs. set() waits for those readers, so a thread must
+// not call it while holding a snapshot.
+template <typename VALUE, size_t STRIPES = 16>
+class concurrent_dynamic_collection {
+public:
+    using iterator = dynamic_iterator<VALUE>;
+
+private:
+    struct source {
+        std::function<iterator()> get_begin;
+        std::function<iterator()> get_end;
+    };
+
+    struct alignas(64) reader_count {
+        std::atomic<size_t> value{0};
+    };
+
+public:
+    class snapshot {
+    public:
+        snapshot(snapshot &&other)
+            : m_source(other.m_source), m_count(other.m_count) {
+            other.m_count = nullptr;
+        }
+
+        snapshot(const snapshot &) = delete;
+        snapshot& operator=(const snapshot &) = delete;
+
+        ~snapshot() {
+            if (m_count != nullptr) {
+                m_count->fetch_sub(1);
+            }
+        }
+
+        iterator begin() const { return m_source->get_begin(); }
+        iterator end() const { return m_source->get_end(); }
+
+    private:
+        friend class concurrent_dynamic_collection;
+
+        snapshot(const source *src, std::atomic<size_t> *count)
+            : m_source(src), m_count(count) {}
+
+        const source *m_source;
+        std::atomic<size_t> *m_count;
+    };
+
+    concurrent_dynamic_collection() : m_current(new source()) {}
+
+    template <typename COLLECTION>
+    concurrent_dynamic_collection(COLLECTION &collection)
+        : m_current(make_source(collection)) {}
+
+    concurrent_dynamic_collection(const concurrent_dynamic_collection &) =
+        delete;
+    concurrent_dynamic_collection& operator=(
+        const concurrent_dynamic_collection &) = delete;
+
+    ~concurrent_dynamic_collection() { delete m_current.load(); }
+
+    template <typename COLLECTION>
+    void set(COLLECTION &collection) {
+        source *next = make_source(collection);
+
+        std::lock_guard<std::mutex> lock(m_writer);
+        source *old = m_current.exchange(next);
+
+        // A reader holding old registered in one of the two epochs before
+        // the exchange. Flipping the epoch sends new readers to the other
+        // set of counts, so each set drains in turn.
+        for (int flip = 0; flip < 2; ++flip) {
+            size_t epoch = m_epoch.fetch_add(1);
+            for (reader_count &count : m_readers[epoch & 1]) {
+                while (count.value.load() != 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        delete old;
+    }
+
+    snapshot read() {
+        std::atomic<size_t> &count =
+            m_readers[m_epoch.load() & 1][reader_stripe()].value;
+        count.fetch_add(1);
+        return snapshot(m_current.load(), &count);
+    }
+
+private:
+    template <typename COLLECTION>
+    static source* make_source(COLLECTION &collection) {
+        static_assert(std::is_same<
+           typename std::iterator_traits<
+                      typename COLLECTION::iterator>::value_type,
+           VALUE>::value);
+        return new source{
+            [&collection]() -> iterator {
+                return make_dynamic_iterator(collection.begin());
+            },
+            [&collection]() -> iterator {
+                return make_dynamic_iterator(collection.end());
+            }};
+    }
+
+    static size_t reader_stripe() {
+        static std::atomic<size_t> next_stripe{0};
+        thread_local size_t stripe = next_stripe.fetch_add(1) % STRIPES;
+        return stripe;
+    }
+
+    std::atomic<source*> m_current;
+    std::atomic<size_t> m_epoch{0};
+    reader_count m_readers[2][STRIPES];
+    std::mutex m_writer;
+};
+
 template <typename ITER>
 class slice {
 public:
@@ -206,6 +334,172 @@ auto make_slice(B &&b, E &&e) {
                                                std::forward<E>(e));
 }
 
+// Ranges that only refer to elements owned elsewhere, so their iterators
+// stay valid after the range object itself is gone.
+template <typename> struct is_range_view : public std::false_type {};
+
+template <typename ITER>
+struct is_range_view<slice<ITER>> : public std::true_type {};
+
+template <typename VALUE>
+struct is_range_view<dynamic_collection<VALUE>> : public std::true_type {};
+
+// Lazily merges any number of sorted sources, each accessed through a
+// dynamic_iterator so different container types can be mixed. The sources
+// are kept in a loser tree, so producing each element costs log2(N)
+// comparisons and no allocation. Ties between sources are not ordered.
+template <typename VALUE, typename COMPARE = std::less<VALUE>>
+class merge_range {
+public:
+    using source_iterator = dynamic_iterator<VALUE>;
+    using reference_type = typename source_iterator::reference_type;
+
+    class iterator {
+    public:
+        using value_type = typename source_iterator::value_type;
+        using reference = reference_type;
+        using pointer = typename source_iterator::pointer_type;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::input_iterator_tag;
+
+        iterator() : m_range(nullptr) {}
+        explicit iterator(merge_range *range) : m_range(range) {}
+
+        iterator& operator++() {
+            m_range->advance();
+            return *this;
+        }
+
+        reference_type operator*() const { return m_range->top(); }
+
+        bool operator==(const iterator &other) const {
+            return at_end() == other.at_end();
+        }
+        bool operator!=(const iterator &other) const {
+            return !(*this == other);
+        }
+    private:
+        bool at_end() const { return m_range == nullptr || m_range->empty(); }
+
+        merge_range *m_range;
+    };
+
+    merge_range(COMPARE comp = COMPARE()) : m_comp(std::move(comp)) {}
+
+    template <typename ...COLLECTIONS>
+    merge_range(COMPARE comp, COLLECTIONS &&...collections)
+        : m_comp(std::move(comp)) {
+        m_cursors.reserve(sizeof...(COLLECTIONS));
+        static_cast<void>((... , add(std::forward<COLLECTIONS>(collections))));
+    }
+
+    // Only the iterators are kept, so containers must outlive the merge and
+    // are taken as lvalues. Temporary views (slice, dynamic_collection) are
+    // fine since their iterators point into the underlying container.
+    template <typename COLLECTION>
+    void add(COLLECTION &&collection) {
+        static_assert(std::is_lvalue_reference<COLLECTION>::value ||
+                      is_range_view<std::decay_t<COLLECTION>>::value,
+                      "merge_range would dangle on a temporary container");
+        m_cursors.emplace_back(source_iterator(collection.begin()),
+                               source_iterator(collection.end()));
+        m_built = false;
+    }
+
+    // Single pass: iterating consumes the sources.
+    iterator begin() {
+        if (!m_built) {
+            build();
+        }
+        return iterator(this);
+    }
+    iterator end() { return iterator(); }
+
+    bool empty() {
+        if (!m_built) {
+            build();
+        }
+        return m_cursors.empty() || m_exhausted[m_winner];
+    }
+
+private:
+    // The end check is a virtual call plus a dynamic_cast, so it is done
+    // once per advance and cached rather than on every match.
+    void update_exhausted(size_t source) {
+        m_exhausted[source] =
+            m_cursors[source].first == m_cursors[source].second;
+    }
+
+    // exhausted sources sort after everything else
+    bool beats(size_t a, size_t b) {
+        if (m_exhausted[a]) {
+            return false;
+        }
+        if (m_exhausted[b]) {
+            return true;
+        }
+        return m_comp(*m_cursors[a].first, *m_cursors[b].first);
+    }
+
+    // Internal nodes are 1..N-1, leaf for source i is node N + i. Each
+    // internal node holds the loser of the match played there and the
+    // overall winner is kept separately.
+    size_t build_node(size_t node) {
+        size_t sources = m_cursors.size();
+        if (node >= sources) {
+            return node - sources;
+        }
+        size_t left = build_node(2 * node);
+        size_t right = build_node(2 * node + 1);
+        if (beats(right, left)) {
+            m_losers[node] = left;
+            return right;
+        }
+        m_losers[node] = right;
+        return left;
+    }
+
+    void build() {
+        m_losers.assign(m_cursors.size(), 0);
+        m_exhausted.assign(m_cursors.size(), false);
+        for (size_t source = 0; source < m_cursors.size(); ++source) {
+            update_exhausted(source);
+        }
+        m_winner = m_cursors.empty() ? 0 : build_node(1);
+        m_built = true;
+    }
+
+    reference_type top() { return *m_cursors[m_winner].first; }
+
+    // Only the path from the winner's leaf to the root needs replaying.
+    void advance() {
+        ++m_cursors[m_winner].first;
+        update_exhausted(m_winner);
+        size_t winner = m_winner;
+        for (size_t node = (winner + m_cursors.size()) / 2; node > 0;
+             node /= 2) {
+            if (beats(m_losers[node], winner)) {
+                std::swap(m_losers[node], winner);
+            }
+        }
+        m_winner = winner;
+    }
+
+    COMPARE m_comp;
+    std::vector<std::pair<source_iterator, source_iterator>> m_cursors;
+    std::vector<size_t> m_losers;
+    std::vector<char> m_exhausted;
+    size_t m_winner = 0;
+    bool m_built = false;
+};
+
+template <typename VALUE, typename COMPARE, typename ...COLLECTIONS>
+merge_range<VALUE, COMPARE> make_merge_range(COMPARE comp,
+                                             COLLECTIONS &&...collections) {
+    return merge_range<VALUE, COMPARE>(std::move(comp),
+                                       std::forward<COLLECTIONS>(collections)...);
+}
+
 }
 
 #endif
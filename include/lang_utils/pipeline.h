@@ -0,0 +1,317 @@
+#ifndef LANG_UTILS_PIPELINE_H
+#define LANG_UTILS_PIPELINE_H
+
+#include <lang_utils/tuple.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lang_utils {
+
+// Bounded single producer, single consumer queue. Items move in batches so
+// the shared indices are only touched once per batch, and each side keeps
+// a cached copy of the other side's index so it only reads the shared one
+// when the cached value can't satisfy the batch.
+template <typename T>
+class spsc_ring {
+public:
+    using value_type = T;
+
+    explicit spsc_ring(size_t capacity)
+        : m_capacity(round_up(capacity)),
+          m_slots(new std::optional<T>[m_capacity]) {}
+
+    spsc_ring(const spsc_ring &) = delete;
+    spsc_ring& operator=(const spsc_ring &) = delete;
+
+    size_t capacity() const { return m_capacity; }
+
+    // Moves all of items in, waiting while the ring is full. Returns false
+    // if abort was raised before everything fit.
+    bool push_batch(std::vector<T> &items, const std::atomic<bool> &abort) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t pushed = 0;
+        while (pushed < items.size()) {
+            size_t room = m_capacity - (head - m_tail_cache);
+            if (room == 0) {
+                m_tail_cache = m_tail.load(std::memory_order_acquire);
+                room = m_capacity - (head - m_tail_cache);
+            }
+            if (room == 0) {
+                if (abort.load(std::memory_order_relaxed)) {
+                    return false;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            size_t count = std::min(room, items.size() - pushed);
+            for (size_t i = 0; i < count; ++i) {
+                m_slots[(head + i) & (m_capacity - 1)].emplace(
+                    std::move(items[pushed + i]));
+            }
+            head += count;
+            pushed += count;
+            m_head.store(head, std::memory_order_release);
+        }
+        return true;
+    }
+
+    // Replaces items with up to max queued items, waiting while the ring
+    // is empty. Returns false once the ring is closed and drained, or if
+    // abort was raised.
+    bool pop_batch(std::vector<T> &items, size_t max,
+                   const std::atomic<bool> &abort) {
+        items.clear();
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            size_t available = m_head_cache - tail;
+            if (available < max) {
+                bool closed = m_closed.load(std::memory_order_acquire);
+                m_head_cache = m_head.load(std::memory_order_acquire);
+                available = m_head_cache - tail;
+                if (available == 0) {
+                    if (closed || abort.load(std::memory_order_relaxed)) {
+                        return false;
+                    }
+                    std::this_thread::yield();
+                    continue;
+                }
+            }
+            size_t count = std::min(available, max);
+            for (size_t i = 0; i < count; ++i) {
+                std::optional<T> &slot = m_slots[(tail + i) & (m_capacity - 1)];
+                items.push_back(std::move(*slot));
+                slot.reset();
+            }
+            m_tail.store(tail + count, std::memory_order_release);
+            return true;
+        }
+    }
+
+    // Called by the producer after its last push.
+    void close() { m_closed.store(true, std::memory_order_release); }
+
+private:
+    static size_t round_up(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    const size_t m_capacity;
+    std::unique_ptr<std::optional<T>[]> m_slots;
+
+    alignas(64) std::atomic<size_t> m_head{0};
+    size_t m_tail_cache = 0;
+
+    alignas(64) std::atomic<size_t> m_tail{0};
+    size_t m_head_cache = 0;
+
+    alignas(64) std::atomic<bool> m_closed{false};
+};
+
+template <typename T>
+struct make_spsc_ring { using type = spsc_ring<T>; };
+
+// types is std::tuple<IN, stage 0 output, stage 1 output, ...>
+template <typename IN, typename... STAGES> struct stage_chain;
+
+template <typename IN>
+struct stage_chain<IN> {
+    using types = std::tuple<IN>;
+};
+
+template <typename IN, typename STAGE, typename... REST>
+struct stage_chain<IN, STAGE, REST...> {
+    static_assert(std::is_invocable<STAGE&, IN&&>::value,
+                  "Pipeline stage cannot take the previous stage's output");
+
+    using output = std::decay_t<std::invoke_result_t<STAGE&, IN&&>>;
+
+    static_assert(!std::is_void<output>::value,
+                  "Pipeline stages must return a value");
+
+    using types = decltype(std::tuple_cat(
+        std::declval<std::tuple<IN>>(),
+        std::declval<typename stage_chain<output, REST...>::types>()));
+};
+
+// Runs every stage of a tuple of stages on its own thread, connected by
+// bounded spsc_rings. Each stage is called with the previous stage's
+// output; the first gets the input range's elements. Order is preserved.
+template <typename... STAGES>
+class pipeline {
+public:
+    static_assert(sizeof...(STAGES) > 0, "Pipeline needs at least one stage");
+
+    template <typename IN>
+    using output_type = std::tuple_element_t<sizeof...(STAGES),
+        typename stage_chain<IN, STAGES...>::types>;
+
+    explicit pipeline(std::tuple<STAGES...> stages, size_t capacity = 1024,
+                      size_t batch = 64)
+        : m_stages(std::move(stages)), m_capacity(capacity),
+          m_batch(batch == 0 ? 1 : batch) {}
+
+    // Feeds [begin, end) through the stages and writes the results to out
+    // from the calling thread. An exception thrown by a stage stops the
+    // pipeline and is rethrown here.
+    template <typename ITER, typename OUT_ITER>
+    OUT_ITER run(ITER begin, ITER end, OUT_ITER out) {
+        using input = typename std::iterator_traits<ITER>::value_type;
+        using types = typename stage_chain<input, STAGES...>::types;
+        using queues_type =
+            typename transform_tuple_type<make_spsc_ring, types>::type;
+        constexpr size_t queue_count = sizeof...(STAGES) + 1;
+
+        std::unique_ptr<queues_type> queues = make_queues<queues_type>(
+            std::make_index_sequence<queue_count>());
+        std::atomic<bool> failed{false};
+        std::exception_ptr errors[queue_count + 1];
+        std::vector<std::thread> threads;
+        threads.reserve(queue_count);
+
+        // A thread that fails to start must not leave the ones already
+        // running touching the rings once they are freed, nor be destroyed
+        // while joinable.
+        try {
+            threads.emplace_back([&, begin, end]() mutable {
+                spsc_ring<input> &first = std::get<0>(*queues);
+                try {
+                    std::vector<input> items;
+                    items.reserve(m_batch);
+                    while (begin != end) {
+                        items.clear();
+                        for (; begin != end && items.size() < m_batch;
+                             ++begin) {
+                            items.push_back(*begin);
+                        }
+                        if (!first.push_batch(items, failed)) {
+                            break;
+                        }
+                    }
+                } catch (...) {
+                    errors[0] = std::current_exception();
+                    failed = true;
+                }
+                first.close();
+            });
+
+            foreach_tuple_p(stage_launcher<queues_type>{
+                                *queues, threads, failed, errors, m_batch},
+                            m_stages);
+        } catch (...) {
+            failed = true;
+            foreach_tuple([](auto &ring) { ring.close(); }, *queues);
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+            throw;
+        }
+
+        auto &last = std::get<queue_count - 1>(*queues);
+        try {
+            std::vector<std::tuple_element_t<queue_count - 1, types>> items;
+            items.reserve(m_batch);
+            while (last.pop_batch(items, m_batch, failed)) {
+                for (auto &item : items) {
+                    *out = std::move(item);
+                    ++out;
+                }
+            }
+        } catch (...) {
+            errors[queue_count] = std::current_exception();
+            failed = true;
+        }
+
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        for (std::exception_ptr &error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        return out;
+    }
+
+    std::tuple<STAGES...>& stages() { return m_stages; }
+
+private:
+    template <typename QUEUES>
+    struct stage_launcher {
+        QUEUES &queues;
+        std::vector<std::thread> &threads;
+        std::atomic<bool> &failed;
+        std::exception_ptr *errors;
+        size_t batch;
+
+        template <size_t POS, typename STAGE>
+        void operator()(STAGE &stage) const {
+            auto &in = std::get<POS>(queues);
+            auto &out = std::get<POS + 1>(queues);
+            std::atomic<bool> &abort = failed;
+            std::exception_ptr &error = errors[POS + 1];
+            size_t max = batch;
+
+            threads.emplace_back([&in, &out, &stage, &abort, &error, max]() {
+                using input =
+                    typename std::decay_t<decltype(in)>::value_type;
+                using output =
+                    typename std::decay_t<decltype(out)>::value_type;
+                try {
+                    std::vector<input> inputs;
+                    std::vector<output> outputs;
+                    inputs.reserve(max);
+                    outputs.reserve(max);
+                    while (in.pop_batch(inputs, max, abort)) {
+                        outputs.clear();
+                        for (input &item : inputs) {
+                            outputs.push_back(stage(std::move(item)));
+                        }
+                        if (!out.push_batch(outputs, abort)) {
+                            break;
+                        }
+                    }
+                } catch (...) {
+                    error = std::current_exception();
+                    abort = true;
+                }
+                out.close();
+            });
+        }
+    };
+
+    template <typename QUEUES, size_t... INDS>
+    std::unique_ptr<QUEUES> make_queues(std::index_sequence<INDS...>) const {
+        return std::unique_ptr<QUEUES>(
+            new QUEUES((static_cast<void>(INDS), m_capacity)...));
+    }
+
+    std::tuple<STAGES...> m_stages;
+    size_t m_capacity;
+    size_t m_batch;
+};
+
+template <typename... STAGES>
+pipeline<STAGES...> make_pipeline(std::tuple<STAGES...> stages,
+                                  size_t capacity = 1024, size_t batch = 64) {
+    return pipeline<STAGES...>(std::move(stages), capacity, batch);
+}
+
+}
+
+#endif
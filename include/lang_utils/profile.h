@@ -0,0 +1,148 @@
+#ifndef LANG_UTILS_PROFILE_H
+#define LANG_UTILS_PROFILE_H
+
+#include <lang_utils/tuple.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <utility>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+namespace lang_utils {
+
+// Profilers for make_profiled. A profiler only needs a
+// measure<I, ELEM>(call) member that invokes call and returns its result.
+
+// Does nothing, so a profiled loop compiles to the plain one.
+struct null_profiler {
+    template <size_t I, typename ELEM, typename CALL>
+    decltype(auto) measure(CALL &&call) {
+        return std::forward<CALL>(call)();
+    }
+};
+
+struct profile_entry {
+    // bucket b counts calls that took [2^(b-1), 2^b) nanoseconds
+    static constexpr size_t buckets = 65;
+
+    const std::type_info *type = nullptr;
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    std::array<uint64_t, buckets> histogram{};
+
+    void record(uint64_t ns) {
+        ++count;
+        total_ns += ns;
+        max_ns = ns > max_ns ? ns : max_ns;
+        ++histogram[bucket(ns)];
+    }
+
+    double mean_ns() const {
+        return count == 0 ? 0.0 : double(total_ns) / double(count);
+    }
+
+    // Upper bound of the histogram bucket holding the given fraction of
+    // calls, e.g. percentile_ns(0.99).
+    uint64_t percentile_ns(double fraction) const {
+        uint64_t wanted = uint64_t(fraction * double(count));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets; ++b) {
+            seen += histogram[b];
+            if (seen > wanted || seen == count) {
+                return b == 0 ? 0 : (b >= 64 ? max_ns : (uint64_t(1) << b));
+            }
+        }
+        return max_ns;
+    }
+
+    std::string type_name() const {
+        if (type == nullptr) {
+            return std::string();
+        }
+#if defined(__GNUG__)
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(type->name(), nullptr, nullptr,
+                                              &status);
+        if (status == 0 && demangled != nullptr) {
+            std::string name(demangled);
+            std::free(demangled);
+            return name;
+        }
+#endif
+        return type->name();
+    }
+
+    static size_t bucket(uint64_t ns) {
+#if defined(__GNUC__)
+        return ns == 0 ? 0 : size_t(64 - __builtin_clzll(ns));
+#else
+        size_t b = 0;
+        for (; ns != 0; ns >>= 1) {
+            ++b;
+        }
+        return b;
+#endif
+    }
+};
+
+// Records wall time and call counts per tuple index. N is the size of the
+// tuples being iterated.
+template <size_t N, typename CLOCK = std::chrono::steady_clock>
+class tuple_profiler {
+public:
+    template <size_t I, typename ELEM, typename CALL>
+    decltype(auto) measure(CALL &&call) {
+        static_assert(I < N, "Tuple is larger than the profiler");
+        m_entries[I].type = &typeid(ELEM);
+        scope_timer timer{m_entries[I], CLOCK::now()};
+        return std::forward<CALL>(call)();
+    }
+
+    const profile_entry& operator[](size_t index) const {
+        return m_entries[index];
+    }
+
+    size_t size() const { return N; }
+
+    void reset() { m_entries = {}; }
+
+    void report(std::ostream &out) const {
+        for (size_t i = 0; i < N; ++i) {
+            const profile_entry &entry = m_entries[i];
+            out << i << " " << entry.type_name()
+                << ": calls " << entry.count
+                << " total_ns " << entry.total_ns
+                << " mean_ns " << entry.mean_ns()
+                << " p99_ns " << entry.percentile_ns(0.99)
+                << " max_ns " << entry.max_ns << "\n";
+        }
+    }
+
+private:
+    struct scope_timer {
+        profile_entry &entry;
+        typename CLOCK::time_point start;
+
+        ~scope_timer() {
+            entry.record(uint64_t(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    CLOCK::now() - start).count()));
+        }
+    };
+
+    std::array<profile_entry, N> m_entries;
+};
+
+}
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef LANG_UTILS_SERIALIZE_H
+#define LANG_UTILS_SERIALIZE_H
+
+#include <lang_utils/tuple.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace lang_utils {
+
+// Tuples are packed field after field with no padding, every field stored
+// little-endian. Only fields with the same size and representation on every
+// platform are supported: fixed width integers, IEEE 754 float and double,
+// bool (one byte, 0 or 1) and enums with an explicit fixed width underlying
+// type. The size and offset of every field is then a compile time constant
+// and a whole record can be written into a caller owned buffer without any
+// intermediate allocation.
+
+template <typename T>
+struct is_fixed_width_integer : public std::integral_constant<bool,
+    std::is_same<T, int8_t>::value || std::is_same<T, uint8_t>::value ||
+    std::is_same<T, int16_t>::value || std::is_same<T, uint16_t>::value ||
+    std::is_same<T, int32_t>::value || std::is_same<T, uint32_t>::value ||
+    std::is_same<T, int64_t>::value || std::is_same<T, uint64_t>::value> {};
+
+// Only enums with a fixed underlying type can be list initialized from it.
+template <typename T, typename = void>
+struct has_fixed_underlying_type : public std::false_type {};
+
+template <typename T>
+struct has_fixed_underlying_type<T, std::void_t<
+    std::enable_if_t<std::is_enum<T>::value>,
+    decltype(T{std::underlying_type_t<T>()})>> : public std::true_type {};
+
+// type is how a field is stored; it is missing for unsupported fields.
+template <typename T, typename = void>
+struct serialized_field_type {};
+
+template <>
+struct serialized_field_type<bool> {
+    using type = uint8_t;
+};
+
+template <typename T>
+struct serialized_field_type<T, std::enable_if_t<
+    is_fixed_width_integer<T>::value>> {
+    using type = T;
+};
+
+template <typename T>
+struct serialized_field_type<T, std::enable_if_t<
+    std::is_same<T, float>::value || std::is_same<T, double>::value>> {
+    static_assert(std::numeric_limits<T>::is_iec559,
+                  "float and double must be IEEE 754 to be serialized");
+    using type = T;
+};
+
+template <typename T>
+struct serialized_field_type<T, std::enable_if_t<
+    has_fixed_underlying_type<T>::value>> : public
+    serialized_field_type<std::underlying_type_t<T>> {};
+
+template <typename T, typename = void>
+struct is_serializable_field : public std::false_type {};
+
+template <typename T>
+struct is_serializable_field<T, std::void_t<
+    typename serialized_field_type<T>::type>> : public std::true_type {};
+
+template <typename T>
+constexpr size_t serialized_field_size() {
+    if constexpr (is_serializable_field<T>::value) {
+        return sizeof(typename serialized_field_type<T>::type);
+    } else {
+        return 0;
+    }
+}
+
+template <typename> struct serialized_size;
+
+template <typename... ARGS>
+struct serialized_size<std::tuple<ARGS...>> : public
+    std::integral_constant<size_t,
+        (size_t(0) + ... + serialized_field_size<ARGS>())> {
+    static_assert((... && is_serializable_field<ARGS>::value),
+                  "Only fixed width integers, float, double, bool and enums "
+                  "with a fixed width underlying type can be serialized");
+};
+
+template <typename TUPLE>
+static constexpr size_t const serialized_size_v =
+    serialized_size<std::decay_t<TUPLE>>::value;
+
+template <size_t, typename> struct serialized_offset;
+
+template <typename... ARGS>
+struct serialized_offset<0, std::tuple<ARGS...>> : public
+    std::integral_constant<size_t, 0> {};
+
+template <size_t I, typename... ARGS>
+struct serialized_offset<I, std::tuple<ARGS...>> : public
+    std::integral_constant<size_t,
+        serialized_offset<I - 1, std::tuple<ARGS...>>::value +
+        serialized_field_size<
+            std::tuple_element_t<I - 1, std::tuple<ARGS...>>>()> {};
+
+template <size_t I, typename TUPLE>
+static constexpr size_t const serialized_offset_v =
+    serialized_offset<I, std::decay_t<TUPLE>>::value;
+
+constexpr bool host_is_little_endian() {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+    return __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__;
+#else
+    return true;
+#endif
+}
+
+// On little-endian hosts both of these are a single memcpy, which the
+// compiler turns into one (possibly unaligned) load or store.
+template <typename T>
+void store_le(char *out, const T &value) {
+    if constexpr (host_is_little_endian() || sizeof(T) == 1) {
+        std::memcpy(out, &value, sizeof(T));
+    } else {
+        const char *bytes = reinterpret_cast<const char*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            out[i] = bytes[sizeof(T) - 1 - i];
+        }
+    }
+}
+
+template <typename T>
+T load_le(const char *in) {
+    T value;
+    if constexpr (host_is_little_endian() || sizeof(T) == 1) {
+        std::memcpy(&value, in, sizeof(T));
+    } else {
+        char *bytes = reinterpret_cast<char*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            bytes[i] = in[sizeof(T) - 1 - i];
+        }
+    }
+    return value;
+}
+
+template <typename T>
+void store_field(char *out, const T &value) {
+    store_le(out, static_cast<typename serialized_field_type<T>::type>(value));
+}
+
+// bool is read back with != 0, so any byte in an untrusted buffer gives a
+// valid value.
+template <typename T>
+T load_field(const char *in) {
+    auto stored = load_le<typename serialized_field_type<T>::type>(in);
+    if constexpr (std::is_same<T, bool>::value) {
+        return stored != 0;
+    } else {
+        return static_cast<T>(stored);
+    }
+}
+
+template <typename TUPLE>
+struct serialize_field {
+    char *out;
+
+    template <size_t POS, typename ARG>
+    void operator()(const ARG &arg) const {
+        store_field(out + serialized_offset_v<POS, TUPLE>, arg);
+    }
+};
+
+template <typename TUPLE>
+struct deserialize_field {
+    const char *in;
+
+    template <size_t POS, typename ARG>
+    void operator()(ARG &arg) const {
+        arg = load_field<ARG>(in + serialized_offset_v<POS, TUPLE>);
+    }
+};
+
+// Writes serialized_size_v<TUPLE> bytes to out and returns the position
+// just past them, so records can be streamed back to back into one buffer.
+template <typename TUPLE>
+char* serialize_tuple(const TUPLE &tuple, char *out) {
+    using tuple_type = std::decay_t<TUPLE>;
+    foreach_tuple_p(serialize_field<tuple_type>{out}, tuple);
+    return out + serialized_size_v<tuple_type>;
+}
+
+// Reads serialized_size_v<TUPLE> bytes from in into tuple and returns the
+// position just past them.
+template <typename TUPLE>
+const char* deserialize_tuple(TUPLE &tuple, const char *in) {
+    using tuple_type = std::decay_t<TUPLE>;
+    foreach_tuple_p(deserialize_field<tuple_type>{in}, tuple);
+    return in + serialized_size_v<tuple_type>;
+}
+
+template <typename TUPLE>
+TUPLE deserialize_tuple(const char *in) {
+    TUPLE tuple;
+    deserialize_tuple(tuple, in);
+    return tuple;
+}
+
+template <typename ITER>
+char* serialize_tuples(ITER begin, ITER end, char *out) {
+    for (; begin != end; ++begin) {
+        out = serialize_tuple(*begin, out);
+    }
+    return out;
+}
+
+// Reads fields in place from a serialized record, e.g. one inside a memory
+// mapped file, without materializing the whole tuple.
+template <typename TUPLE>
+class tuple_view {
+public:
+    using tuple_type = TUPLE;
+
+    explicit tuple_view(const char *data) : m_data(data) {}
+
+    template <size_t I>
+    std::tuple_element_t<I, TUPLE> get() const {
+        return load_field<std::tuple_element_t<I, TUPLE>>(
+                   m_data + serialized_offset_v<I, TUPLE>);
+    }
+
+    TUPLE materialize() const { return deserialize_tuple<TUPLE>(m_data); }
+
+    const char* data() const { return m_data; }
+    const char* next() const { return m_data + serialized_size_v<TUPLE>; }
+
+private:
+    const char *m_data;
+};
+
+template <size_t I, typename TUPLE>
+std::tuple_element_t<I, TUPLE> get(const tuple_view<TUPLE> &view) {
+    return view.template get<I>();
+}
+
+}
+
+#endif
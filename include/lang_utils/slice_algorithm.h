@@ -0,0 +1,685 @@
+#ifndef LANG_UTILS_SLICE_ALGORITHM_H
+#define LANG_UTILS_SLICE_ALGORITHM_H
+
+#include <lang_utils/iterator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LANG_UTILS_X86_SIMD 1
+#endif
+
+namespace lang_utils {
+
+// Kernels for slices over contiguous float, double or integer (other than
+// bool) data. Other slices fall back to the standard algorithms.
+//
+// Integer sums and dot products wrap around in the element type, so they
+// give the same result as std::accumulate and std::inner_product whenever
+// those don't overflow.
+//
+// Floating point sums are not reassociated behind the caller's back: every
+// instruction set, including the scalar fallback, accumulates into the same
+// fixed set of lanes, lane j taking elements j, j + LANES, j + 2 * LANES...
+// The lanes are then folded pairwise and the leftover tail added in order,
+// so results are bit identical whichever instruction set runs. They do
+// differ from a plain left to right std::accumulate. slice_dot relies on
+// multiplies and adds not being fused, so don't build with
+// -ffp-contract=fast on a target with FMA if that matters.
+
+enum class simd_level {
+    scalar,
+    sse2,
+    avx2
+};
+
+inline simd_level detected_simd_level() {
+#if defined(LANG_UTILS_X86_SIMD)
+    static const simd_level level = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return simd_level::avx2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return simd_level::sse2;
+        }
+        return simd_level::scalar;
+    }();
+    return level;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+template <typename ITER>
+struct is_contiguous_iterator : public std::integral_constant<bool,
+    std::is_pointer<ITER>::value ||
+    (!std::is_same<typename std::iterator_traits<ITER>::value_type,
+                   bool>::value &&
+     (std::is_same<ITER, typename std::vector<
+         typename std::iterator_traits<ITER>::value_type>::iterator>::value ||
+      std::is_same<ITER, typename std::vector<
+         typename std::iterator_traits<ITER>::value_type>::const_iterator>::value))> {};
+
+template <typename T>
+struct is_simd_element : public std::integral_constant<bool,
+    std::is_same<T, float>::value || std::is_same<T, double>::value ||
+    (std::is_integral<T>::value && !std::is_same<T, bool>::value)> {};
+
+template <typename ITER>
+struct is_simd_slice : public std::integral_constant<bool,
+    is_contiguous_iterator<ITER>::value &&
+    is_simd_element<typename std::iterator_traits<ITER>::value_type>::value> {};
+
+namespace simd_detail {
+
+// Two 32 byte registers' worth, so even AVX2 has two independent
+// accumulators in flight.
+template <typename T>
+constexpr size_t lanes = 64 / sizeof(T);
+
+// Integers are summed unsigned, where overflow is defined to wrap.
+template <typename T>
+using accumulator_t = typename std::conditional_t<std::is_integral<T>::value,
+    std::make_unsigned<T>, std::common_type<T>>::type;
+
+template <typename T>
+accumulator_t<T> product(T a, T b) {
+    if constexpr (std::is_integral<T>::value) {
+        // at least unsigned int, so narrow types aren't promoted to int
+        using wide = std::common_type_t<accumulator_t<T>, unsigned>;
+        return accumulator_t<T>(wide(a) * wide(b));
+    } else {
+        return a * b;
+    }
+}
+
+template <typename T>
+T fold_sum(T (&acc)[lanes<T>]) {
+    for (size_t width = lanes<T> / 2; width > 0; width /= 2) {
+        for (size_t i = 0; i < width; ++i) {
+            acc[i] += acc[i + width];
+        }
+    }
+    return acc[0];
+}
+
+template <typename T>
+T fold_min(T (&acc)[lanes<T>]) {
+    for (size_t width = lanes<T> / 2; width > 0; width /= 2) {
+        for (size_t i = 0; i < width; ++i) {
+            acc[i] = acc[i + width] < acc[i] ? acc[i + width] : acc[i];
+        }
+    }
+    return acc[0];
+}
+
+template <typename T>
+T fold_max(T (&acc)[lanes<T>]) {
+    for (size_t width = lanes<T> / 2; width > 0; width /= 2) {
+        for (size_t i = 0; i < width; ++i) {
+            acc[i] = acc[i] < acc[i + width] ? acc[i + width] : acc[i];
+        }
+    }
+    return acc[0];
+}
+
+// Scalar reference kernels, laid out exactly like the vector ones below.
+
+template <typename T>
+T sum_scalar(const T *data, size_t size) {
+    using U = accumulator_t<T>;
+    constexpr size_t L = lanes<T>;
+    U acc[L] = {};
+    size_t i = 0;
+    for (; i + L <= size; i += L) {
+        for (size_t j = 0; j < L; ++j) {
+            acc[j] += U(data[i + j]);
+        }
+    }
+    U total = fold_sum(acc);
+    for (; i < size; ++i) {
+        total += U(data[i]);
+    }
+    return T(total);
+}
+
+template <typename T>
+T dot_scalar(const T *a, const T *b, size_t size) {
+    using U = accumulator_t<T>;
+    constexpr size_t L = lanes<T>;
+    U acc[L] = {};
+    size_t i = 0;
+    for (; i + L <= size; i += L) {
+        for (size_t j = 0; j < L; ++j) {
+            acc[j] += product(a[i + j], b[i + j]);
+        }
+    }
+    U total = fold_sum(acc);
+    for (; i < size; ++i) {
+        total += product(a[i], b[i]);
+    }
+    return T(total);
+}
+
+// Every lane starts from data[0] rather than from its own first element,
+// so a NaN can only take over the result from there, as with
+// std::min_element: anywhere else it never compares less and is skipped.
+template <typename T>
+T min_scalar(const T *data, size_t size) {
+    constexpr size_t L = lanes<T>;
+    T result = data[0];
+    size_t i = 0;
+    if (size >= L) {
+        T acc[L];
+        std::fill(acc, acc + L, data[0]);
+        for (; i + L <= size; i += L) {
+            for (size_t j = 0; j < L; ++j) {
+                acc[j] = data[i + j] < acc[j] ? data[i + j] : acc[j];
+            }
+        }
+        result = fold_min(acc);
+    }
+    for (; i < size; ++i) {
+        result = data[i] < result ? data[i] : result;
+    }
+    return result;
+}
+
+template <typename T>
+T max_scalar(const T *data, size_t size) {
+    constexpr size_t L = lanes<T>;
+    T result = data[0];
+    size_t i = 0;
+    if (size >= L) {
+        T acc[L];
+        std::fill(acc, acc + L, data[0]);
+        for (; i + L <= size; i += L) {
+            for (size_t j = 0; j < L; ++j) {
+                acc[j] = acc[j] < data[i + j] ? data[i + j] : acc[j];
+            }
+        }
+        result = fold_max(acc);
+    }
+    for (; i < size; ++i) {
+        result = result < data[i] ? data[i] : result;
+    }
+    return result;
+}
+
+template <typename T>
+size_t count_scalar(const T *data, size_t size, T value) {
+    return size_t(std::count(data, data + size, value));
+}
+
+template <typename T>
+size_t find_scalar(const T *data, size_t size, T value) {
+    return size_t(std::find(data, data + size, value) - data);
+}
+
+#if defined(LANG_UTILS_X86_SIMD)
+
+// The vector kernels are written once with GCC vector extensions over
+// WIDTH byte vectors and always inlined into the per instruction set entry
+// points at the bottom, which decide the code they compile to.
+
+template <typename T, size_t WIDTH>
+struct vec_types {
+    typedef T vec __attribute__((vector_size(WIDTH)));
+    static constexpr size_t per_vec = WIDTH / sizeof(T);
+    static constexpr size_t count = lanes<T> / per_vec;
+
+    // vectors go through references: returning one by value from a
+    // function without the matching target attribute changes the ABI
+    __attribute__((always_inline))
+    static void load(vec &v, const void *data) {
+        std::memcpy(&v, data, WIDTH);
+    }
+
+    __attribute__((always_inline))
+    static void store(T *data, const vec &v) {
+        std::memcpy(data, &v, WIDTH);
+    }
+
+    template <typename MASK>
+    __attribute__((always_inline))
+    static bool any(const MASK &mask) {
+        uint64_t words[WIDTH / sizeof(uint64_t)];
+        std::memcpy(words, &mask, WIDTH);
+        uint64_t set = 0;
+        for (uint64_t word : words) {
+            set |= word;
+        }
+        return set != 0;
+    }
+};
+
+template <typename T, size_t WIDTH>
+__attribute__((always_inline))
+inline T sum_vec(const T *data, size_t size) {
+    using U = accumulator_t<T>;
+    using types = vec_types<U, WIDTH>;
+    constexpr size_t L = lanes<T>;
+    typename types::vec acc[types::count] = {};
+    size_t i = 0;
+    for (; i + L <= size; i += L) {
+        for (size_t k = 0; k < types::count; ++k) {
+            typename types::vec v;
+            types::load(v, data + i + k * types::per_vec);
+            acc[k] += v;
+        }
+    }
+    U lanes_out[L];
+    for (size_t k = 0; k < types::count; ++k) {
+        types::store(lanes_out + k * types::per_vec, acc[k]);
+    }
+    U total = fold_sum(lanes_out);
+    for (; i < size; ++i) {
+        total += U(data[i]);
+    }
+    return T(total);
+}
+
+template <typename T, size_t WIDTH>
+__attribute__((always_inline))
+inline T dot_vec(const T *a, const T *b, size_t size) {
+    using U = accumulator_t<T>;
+    using types = vec_types<U, WIDTH>;
+    constexpr size_t L = lanes<T>;
+    typename types::vec acc[types::count] = {};
+    size_t i = 0;
+    for (; i + L <= size; i += L) {
+        for (size_t k = 0; k < types::count; ++k) {
+            typename types::vec va, vb;
+            types::load(va, a + i + k * types::per_vec);
+            types::load(vb, b + i + k * types::per_vec);
+            acc[k] += va * vb;
+        }
+    }
+    U lanes_out[L];
+    for (size_t k = 0; k < types::count; ++k) {
+        types::store(lanes_out + k * types::per_vec, acc[k]);
+    }
+    U total = fold_sum(lanes_out);
+    for (; i < size; ++i) {
+        total += product(a[i], b[i]);
+    }
+    return T(total);
+}
+
+template <bool MIN, typename T, size_t WIDTH>
+__attribute__((always_inline))
+inline T extreme_vec(const T *data, size_t size) {
+    using types = vec_types<T, WIDTH>;
+    constexpr size_t L = lanes<T>;
+    T result = data[0];
+    size_t i = 0;
+    if (size >= L) {
+        typename types::vec acc[types::count];
+        for (size_t k = 0; k < types::count; ++k) {
+            acc[k] = typename types::vec{} + data[0];
+        }
+        for (; i + L <= size; i += L) {
+            for (size_t k = 0; k < types::count; ++k) {
+                typename types::vec v;
+                types::load(v, data + i + k * types::per_vec);
+                if constexpr (MIN) {
+                    acc[k] = v < acc[k] ? v : acc[k];
+                } else {
+                    acc[k] = acc[k] < v ? v : acc[k];
+                }
+            }
+        }
+        T lanes_out[L];
+        for (size_t k = 0; k < types::count; ++k) {
+            types::store(lanes_out + k * types::per_vec, acc[k]);
+        }
+        result = MIN ? fold_min(lanes_out) : fold_max(lanes_out);
+    }
+    for (; i < size; ++i) {
+        if constexpr (MIN) {
+            result = data[i] < result ? data[i] : result;
+        } else {
+            result = result < data[i] ? data[i] : result;
+        }
+    }
+    return result;
+}
+
+template <typename T, size_t WIDTH>
+__attribute__((always_inline))
+inline size_t count_vec(const T *data, size_t size, T value) {
+    using types = vec_types<T, WIDTH>;
+    using mask = decltype(typename types::vec() == typename types::vec());
+    constexpr size_t L = lanes<T>;
+    // lane counters are as wide as the elements, so they are flushed
+    // before they could overflow
+    constexpr size_t flush_every = std::min(
+        size_t(1) << 24, (size_t(1) << (8 * sizeof(T) - 1)) - 1);
+
+    typename types::vec needle = typename types::vec{} + value;
+    size_t total = 0;
+    size_t i = 0;
+    while (i + L <= size) {
+        mask acc[types::count] = {};
+        size_t stop = std::min(size - size % L, i + flush_every * L);
+        for (; i < stop; i += L) {
+            for (size_t k = 0; k < types::count; ++k) {
+                typename types::vec v;
+                types::load(v, data + i + k * types::per_vec);
+                acc[k] -= v == needle;
+            }
+        }
+        for (size_t k = 0; k < types::count; ++k) {
+            for (size_t j = 0; j < types::per_vec; ++j) {
+                total += size_t(acc[k][j]);
+            }
+        }
+    }
+    for (; i < size; ++i) {
+        total += data[i] == value;
+    }
+    return total;
+}
+
+template <typename T, size_t WIDTH>
+__attribute__((always_inline))
+inline size_t find_vec(const T *data, size_t size, T value) {
+    using types = vec_types<T, WIDTH>;
+    using mask = decltype(typename types::vec() == typename types::vec());
+    constexpr size_t L = lanes<T>;
+
+    typename types::vec needle = typename types::vec{} + value;
+    size_t i = 0;
+    for (; i + L <= size; i += L) {
+        typename types::vec v;
+        types::load(v, data + i);
+        mask hit = v == needle;
+        for (size_t k = 1; k < types::count; ++k) {
+            types::load(v, data + i + k * types::per_vec);
+            hit |= v == needle;
+        }
+        if (types::any(hit)) {
+            break;
+        }
+    }
+    for (; i < size; ++i) {
+        if (data[i] == value) {
+            return i;
+        }
+    }
+    return size;
+}
+
+template <typename T>
+__attribute__((target("sse2")))
+T sum_sse2(const T *data, size_t size) {
+    return sum_vec<T, 16>(data, size);
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+T sum_avx2(const T *data, size_t size) {
+    return sum_vec<T, 32>(data, size);
+}
+
+template <typename T>
+__attribute__((target("sse2")))
+T dot_sse2(const T *a, const T *b, size_t size) {
+    return dot_vec<T, 16>(a, b, size);
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+T dot_avx2(const T *a, const T *b, size_t size) {
+    return dot_vec<T, 32>(a, b, size);
+}
+
+template <bool MIN, typename T>
+__attribute__((target("sse2")))
+T extreme_sse2(const T *data, size_t size) {
+    return extreme_vec<MIN, T, 16>(data, size);
+}
+
+template <bool MIN, typename T>
+__attribute__((target("avx2")))
+T extreme_avx2(const T *data, size_t size) {
+    return extreme_vec<MIN, T, 32>(data, size);
+}
+
+template <typename T>
+__attribute__((target("sse2")))
+size_t count_sse2(const T *data, size_t size, T value) {
+    return count_vec<T, 16>(data, size, value);
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+size_t count_avx2(const T *data, size_t size, T value) {
+    return count_vec<T, 32>(data, size, value);
+}
+
+template <typename T>
+__attribute__((target("sse2")))
+size_t find_sse2(const T *data, size_t size, T value) {
+    return find_vec<T, 16>(data, size, value);
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+size_t find_avx2(const T *data, size_t size, T value) {
+    return find_vec<T, 32>(data, size, value);
+}
+
+#endif
+
+inline simd_level usable_level(simd_level requested) {
+    return std::min(requested, detected_simd_level());
+}
+
+template <typename T>
+T sum(const T *data, size_t size, simd_level level) {
+#if defined(LANG_UTILS_X86_SIMD)
+    switch (usable_level(level)) {
+    case simd_level::avx2: return sum_avx2(data, size);
+    case simd_level::sse2: return sum_sse2(data, size);
+    case simd_level::scalar: break;
+    }
+#endif
+    return sum_scalar(data, size);
+}
+
+template <typename T>
+T dot(const T *a, const T *b, size_t size, simd_level level) {
+#if defined(LANG_UTILS_X86_SIMD)
+    switch (usable_level(level)) {
+    case simd_level::avx2: return dot_avx2(a, b, size);
+    case simd_level::sse2: return dot_sse2(a, b, size);
+    case simd_level::scalar: break;
+    }
+#endif
+    return dot_scalar(a, b, size);
+}
+
+template <bool MIN, typename T>
+T extreme(const T *data, size_t size, simd_level level) {
+#if defined(LANG_UTILS_X86_SIMD)
+    switch (usable_level(level)) {
+    case simd_level::avx2: return extreme_avx2<MIN>(data, size);
+    case simd_level::sse2: return extreme_sse2<MIN>(data, size);
+    case simd_level::scalar: break;
+    }
+#endif
+    return MIN ? min_scalar(data, size) : max_scalar(data, size);
+}
+
+template <typename T>
+size_t count(const T *data, size_t size, T value, simd_level level) {
+#if defined(LANG_UTILS_X86_SIMD)
+    switch (usable_level(level)) {
+    case simd_level::avx2: return count_avx2(data, size, value);
+    case simd_level::sse2: return count_sse2(data, size, value);
+    case simd_level::scalar: break;
+    }
+#endif
+    return count_scalar(data, size, value);
+}
+
+template <typename T>
+size_t find(const T *data, size_t size, T value, simd_level level) {
+#if defined(LANG_UTILS_X86_SIMD)
+    switch (usable_level(level)) {
+    case simd_level::avx2: return find_avx2(data, size, value);
+    case simd_level::sse2: return find_sse2(data, size, value);
+    case simd_level::scalar: break;
+    }
+#endif
+    return find_scalar(data, size, value);
+}
+
+// Whether converting value to T keeps it equal in their common type, i.e.
+// whether any T could compare equal to it. Checks the range first since
+// converting an out of range floating point value is undefined.
+template <typename T, typename VALUE>
+bool representable_as(const VALUE &value) {
+    if constexpr (std::is_floating_point<VALUE>::value &&
+                  std::is_integral<T>::value) {
+        // both bounds are zero or a power of two, so exact in VALUE
+        VALUE low = VALUE(std::numeric_limits<T>::min());
+        VALUE high = VALUE(std::numeric_limits<T>::max() / 2 + 1) * 2;
+        if (!(value >= low && value < high)) {
+            return false;
+        }
+    } else if constexpr (std::is_floating_point<VALUE>::value &&
+                         (sizeof(VALUE) > sizeof(T))) {
+        if (!(std::abs(value) <= VALUE(std::numeric_limits<T>::max()))) {
+            return std::isinf(value);
+        }
+    }
+    using common = std::common_type_t<T, VALUE>;
+    return common(static_cast<T>(value)) == common(value);
+}
+
+template <typename ITER>
+const typename std::iterator_traits<ITER>::value_type*
+data_of(const slice<ITER> &s) {
+    return s.begin() == s.end() ? nullptr : std::addressof(*s.begin());
+}
+
+template <typename ITER>
+size_t size_of(const slice<ITER> &s) {
+    return size_t(std::distance(s.begin(), s.end()));
+}
+
+}
+
+// level caps the instruction set used, mostly for testing; it is clamped to
+// what the CPU supports. slice_count and slice_find compare like std::count
+// and std::find, in the common type of the element and the needle.
+
+template <typename ITER>
+auto slice_sum(const slice<ITER> &s,
+               simd_level level = detected_simd_level()) {
+    using value_type = typename std::iterator_traits<ITER>::value_type;
+    if constexpr (is_simd_slice<ITER>::value) {
+        return simd_detail::sum(simd_detail::data_of(s),
+                                simd_detail::size_of(s), level);
+    } else {
+        return std::accumulate(s.begin(), s.end(), value_type());
+    }
+}
+
+template <typename ITER_A, typename ITER_B>
+auto slice_dot(const slice<ITER_A> &a, const slice<ITER_B> &b,
+               simd_level level = detected_simd_level()) {
+    using value_type = typename std::iterator_traits<ITER_A>::value_type;
+    assert(std::distance(a.begin(), a.end()) ==
+           std::distance(b.begin(), b.end()));
+    if constexpr (is_simd_slice<ITER_A>::value &&
+                  is_simd_slice<ITER_B>::value &&
+                  std::is_same<value_type, typename std::iterator_traits<
+                                   ITER_B>::value_type>::value) {
+        return simd_detail::dot(simd_detail::data_of(a),
+                                simd_detail::data_of(b),
+                                simd_detail::size_of(a), level);
+    } else {
+        return std::inner_product(a.begin(), a.end(), b.begin(),
+                                  value_type());
+    }
+}
+
+// slice_min and slice_max need a non-empty slice. They agree with
+// std::min_element and std::max_element: NaNs are skipped unless the first
+// element is one, in which case it is the result.
+template <typename ITER>
+auto slice_min(const slice<ITER> &s,
+               simd_level level = detected_simd_level()) {
+    assert(s.begin() != s.end());
+    if constexpr (is_simd_slice<ITER>::value) {
+        return simd_detail::extreme<true>(simd_detail::data_of(s),
+                                          simd_detail::size_of(s), level);
+    } else {
+        return *std::min_element(s.begin(), s.end());
+    }
+}
+
+template <typename ITER>
+auto slice_max(const slice<ITER> &s,
+               simd_level level = detected_simd_level()) {
+    assert(s.begin() != s.end());
+    if constexpr (is_simd_slice<ITER>::value) {
+        return simd_detail::extreme<false>(simd_detail::data_of(s),
+                                           simd_detail::size_of(s), level);
+    } else {
+        return *std::max_element(s.begin(), s.end());
+    }
+}
+
+template <typename ITER, typename VALUE>
+size_t slice_count(const slice<ITER> &s, const VALUE &value,
+                   simd_level level = detected_simd_level()) {
+    using value_type = typename std::iterator_traits<ITER>::value_type;
+    if constexpr (is_simd_slice<ITER>::value) {
+        // a needle the element type can't represent matches nothing
+        if (!simd_detail::representable_as<value_type>(value)) {
+            return 0;
+        }
+        return simd_detail::count(simd_detail::data_of(s),
+                                  simd_detail::size_of(s),
+                                  static_cast<value_type>(value), level);
+    } else {
+        return size_t(std::count(s.begin(), s.end(), value));
+    }
+}
+
+template <typename ITER, typename VALUE>
+ITER slice_find(const slice<ITER> &s, const VALUE &value,
+                simd_level level = detected_simd_level()) {
+    using value_type = typename std::iterator_traits<ITER>::value_type;
+    if constexpr (is_simd_slice<ITER>::value) {
+        if (!simd_detail::representable_as<value_type>(value)) {
+            return s.end();
+        }
+        size_t pos = simd_detail::find(simd_detail::data_of(s),
+                                       simd_detail::size_of(s),
+                                       static_cast<value_type>(value), level);
+        return std::next(s.begin(), pos);
+    } else {
+        return std::find(s.begin(), s.end(), value);
+    }
+}
+
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef LANG_UTILS_TUPLE_H
 #define LANG_UTILS_TUPLE_H
 
+#include <array>
+#include <cstddef>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -32,8 +34,8 @@ struct tuple_sizes_equal : public
     std::integral_constant<size_t, tuple_sizes_equal_v<TUPLES...>> {};
 
 template <size_t N, typename... TUPLES>
-auto slice_tuples(TUPLES&&... tuples) {
-    return std::tie(std::get<N>(std::forward<TUPLES>(tuples))...);
+constexpr auto slice_tuples(TUPLES&&... tuples) {
+    return std::forward_as_tuple(std::get<N>(std::forward<TUPLES>(tuples))...);
 }
 
 enum class pos_kind {
@@ -48,7 +50,7 @@ template <size_t I, typename FUNC>
 struct adapted<pos_kind::none, I, FUNC> {
     FUNC&& func;
     template <typename... ARGS>
-    decltype(auto) operator()(ARGS&&... args) const {
+    constexpr decltype(auto) operator()(ARGS&&... args) const {
         return std::forward<FUNC>(func)(std::forward<ARGS>(args)...);
     }
 };
@@ -57,7 +59,7 @@ template <size_t I, typename FUNC>
 struct adapted<pos_kind::compile_time, I, FUNC> {
     FUNC&& func;
     template <typename... ARGS>
-    decltype(auto) operator()(ARGS&&... args) const {
+    constexpr decltype(auto) operator()(ARGS&&... args) const {
         return std::forward<FUNC>(func).template operator()<I>(std::forward<ARGS>(args)...);
     }
 };
@@ -66,26 +68,72 @@ template <size_t I, typename FUNC>
 struct adapted<pos_kind::run_time, I, FUNC> {
     FUNC&& func;
     template <typename... ARGS>
-    decltype(auto) operator()(ARGS&&... args) const {
+    constexpr decltype(auto) operator()(ARGS&&... args) const {
         return std::forward<FUNC>(func)(I, std::forward<ARGS>(args)...);
     }
 };
 
-template <pos_kind PK, size_t I, typename FUNC>
-adapted<PK, I, FUNC&&> adapt_impl(FUNC&& func) {
-    return {std::forward<FUNC>(func)};
+// Wraps a function passed to the foreach/map/reduce family so every call is
+// handed to PROFILER::measure<I, ELEM>, where ELEM is the element type of the
+// first tuple at position I. See lang_utils/profile.h.
+template <typename PROFILER, typename FUNC>
+struct profiled {
+    PROFILER &profiler;
+    FUNC func;
+};
+
+template <typename PROFILER, typename FUNC>
+constexpr profiled<PROFILER, FUNC> make_profiled(PROFILER &profiler, FUNC&& func) {
+    return {profiler, std::forward<FUNC>(func)};
+}
+
+template <typename> struct is_profiled : public std::false_type {};
+
+template <typename PROFILER, typename FUNC>
+struct is_profiled<profiled<PROFILER, FUNC>> : public std::true_type {};
+
+template <pos_kind PK, size_t I, typename ELEM, typename PROFILER, typename FUNC>
+struct profiled_adapted {
+    PROFILER &profiler;
+    adapted<PK, I, FUNC> inner;
+    template <typename... ARGS>
+    constexpr decltype(auto) operator()(ARGS&&... args) const {
+        return profiler.template measure<I, ELEM>([&]() -> decltype(auto) {
+            return inner(std::forward<ARGS>(args)...);
+        });
+    }
+};
+
+template <size_t I, typename TUPLE, typename...>
+struct first_tuple_element {
+    using type = std::tuple_element_t<I, std::decay_t<TUPLE>>;
+};
+
+template <pos_kind PK, size_t I, typename ELEM = void, typename FUNC>
+constexpr auto adapt_impl(FUNC&& func) {
+    if constexpr (is_profiled<std::decay_t<FUNC>>::value) {
+        using inner_func = decltype((std::forward<FUNC>(func).func));
+        using profiler_type = std::remove_reference_t<
+            decltype(std::forward<FUNC>(func).profiler)>;
+        return profiled_adapted<PK, I, ELEM, profiler_type, inner_func>{
+            func.profiler, {std::forward<FUNC>(func).func}};
+    } else {
+        return adapted<PK, I, FUNC&&>{std::forward<FUNC>(func)};
+    }
 }
 
 template <pos_kind PK, typename FUNC, size_t... INDS, typename... TUPLES>
-void foreach_tuple_impl(FUNC&& func, std::index_sequence<INDS...>,
+constexpr void foreach_tuple_impl(FUNC&& func, std::index_sequence<INDS...>,
                         TUPLES&&... tuples) {
     static_cast<void>((... && (static_cast<void>(
-        std::apply(adapt_impl<PK, INDS>(std::forward<FUNC>(func)),
+        std::apply(adapt_impl<PK, INDS,
+                       typename first_tuple_element<INDS, TUPLES...>::type>(
+                           std::forward<FUNC>(func)),
                    slice_tuples<INDS>(std::forward<TUPLES>(tuples)...))), true)));
 }
 
 template <typename FUNC, typename... TUPLES>
-void foreach_tuple(FUNC&& func, TUPLES&&... tuples) {
+constexpr void foreach_tuple(FUNC&& func, TUPLES&&... tuples) {
     foreach_tuple_impl<pos_kind::none>(
             std::forward<FUNC>(func),
             std::make_index_sequence<tuple_sizes_equal_v<TUPLES...>>{},
@@ -93,7 +141,7 @@ void foreach_tuple(FUNC&& func, TUPLES&&... tuples) {
 }
 
 template <typename FUNC, size_t... INDS, typename... TUPLES>
-void foreach_tuple_i(FUNC&& func, TUPLES&&... tuples) {
+constexpr void foreach_tuple_i(FUNC&& func, TUPLES&&... tuples) {
     foreach_tuple_impl<pos_kind::run_time>(
             std::forward<FUNC>(func),
             std::make_index_sequence<tuple_sizes_equal_v<TUPLES...>>{},
@@ -101,7 +149,7 @@ void foreach_tuple_i(FUNC&& func, TUPLES&&... tuples) {
 }
 
 template <typename FUNC, typename ...TUPLES>
-void foreach_tuple_p(FUNC &&func, TUPLES&& ...tuples) {
+constexpr void foreach_tuple_p(FUNC &&func, TUPLES&& ...tuples) {
     foreach_tuple_impl<pos_kind::compile_time>(
             std::forward<FUNC>(func),
             std::make_index_sequence<tuple_sizes_equal_v<TUPLES...>>{},
@@ -109,16 +157,18 @@ void foreach_tuple_p(FUNC &&func, TUPLES&& ...tuples) {
 }
 
 template <pos_kind PK, typename FUNC, size_t... INDS, typename... TUPLES>
-auto map_tuple_impl(FUNC&& func,
+constexpr auto map_tuple_impl(FUNC&& func,
                     std::index_sequence<INDS...>,
                     TUPLES&&... tuples) {
     return std::make_tuple(
-            std::apply(adapt_impl<PK, INDS>(std::forward<FUNC>(func)),
+            std::apply(adapt_impl<PK, INDS,
+                           typename first_tuple_element<INDS, TUPLES...>::type>(
+                               std::forward<FUNC>(func)),
                        slice_tuples<INDS>(std::forward<TUPLES>(tuples)...))...);
 }
 
 template <typename FUNC, typename ...TUPLES>
-auto map_tuple(FUNC &&func, TUPLES&& ...tuples) {
+constexpr auto map_tuple(FUNC &&func, TUPLES&& ...tuples) {
     return map_tuple_impl<pos_kind::none>(
         std::forward<FUNC>(func),
         std::make_index_sequence<tuple_sizes_equal_v<TUPLES...>>{},
@@ -126,7 +176,7 @@ auto map_tuple(FUNC &&func, TUPLES&& ...tuples) {
 }
 
 template <typename FUNC, typename ...TUPLES>
-auto map_tuple_i(FUNC &&func, TUPLES&& ...tuples) {
+constexpr auto map_tuple_i(FUNC &&func, TUPLES&& ...tuples) {
     return map_tuple_impl<pos_kind::run_time>(
         std::forward<FUNC>(func),
         std::make_index_sequence<tuple_sizes_equal_v<TUPLES...>>{},
@@ -134,7 +184,7 @@ auto map_tuple_i(FUNC &&func, TUPLES&& ...tuples) {
 }
 
 template <typename FUNC, typename ...TUPLES>
-auto map_tuple_p(FUNC &&func, TUPLES&& ...tuples) {
+constexpr auto map_tuple_p(FUNC &&func, TUPLES&& ...tuples) {
     return map_tuple_impl<pos_kind::compile_time>(
         std::forward<FUNC>(func),
         std::make_index_sequence<tuple_sizes_equal_v<TUPLES...>>{},
@@ -149,29 +199,33 @@ struct reduce_tuple_helper {
     // friend auto reduce_tuple(F&&, S&&, T&&...);
 
     template <typename ACCUM>
-    auto operator()(std::index_sequence<LAST_INDEX>, FUNC &&func,
+    constexpr auto operator()(std::index_sequence<LAST_INDEX>, FUNC &&func,
                     ACCUM &&accum,
                     TUPLES&& ...tuples) {
-        return func(std::forward<ACCUM>(accum),
-                    std::get<LAST_INDEX>(tuples)...);
+        return adapt_impl<pos_kind::none, LAST_INDEX,
+                   typename first_tuple_element<LAST_INDEX, TUPLES...>::type>(
+                       func)(std::forward<ACCUM>(accum),
+                             std::get<LAST_INDEX>(tuples)...);
     }
 
     template <typename ACCUM, size_t POS, size_t ...INDICES>
-    auto operator()(std::index_sequence<POS, INDICES...>,
+    constexpr auto operator()(std::index_sequence<POS, INDICES...>,
                     FUNC &&func,
                     ACCUM &&accum,
                     TUPLES&& ...tuples) {
         return (*this)(std::index_sequence<INDICES...>(),
                        std::forward<FUNC>(func),
-                       func(std::forward<ACCUM>(accum),
-                            std::get<POS>(tuples)...),
+                       adapt_impl<pos_kind::none, POS,
+                           typename first_tuple_element<POS, TUPLES...>::type>(
+                               func)(std::forward<ACCUM>(accum),
+                                     std::get<POS>(tuples)...),
                        std::forward<TUPLES>(tuples)...);
     }
 };
 
 template <typename FUNC, typename STARTING, typename ...TUPLES>
-auto reduce_tuple(FUNC &&func, STARTING &&starting, TUPLES&& ...tuples) {
-    static const size_t size = tuple_sizes_equal<TUPLES...>::value;
+constexpr auto reduce_tuple(FUNC &&func, STARTING &&starting, TUPLES&& ...tuples) {
+    constexpr size_t size = tuple_sizes_equal<TUPLES...>::value;
 
     return reduce_tuple_helper<size - 1, FUNC, TUPLES...>()(
                std::make_index_sequence<size>(),
@@ -180,6 +234,22 @@ auto reduce_tuple(FUNC &&func, STARTING &&starting, TUPLES&& ...tuples) {
                std::forward<TUPLES>(tuples)...);
 }
 
+template <typename TUPLE, size_t... INDS>
+constexpr auto tuple_to_array_impl(TUPLE&& tuple, std::index_sequence<INDS...>) {
+    using value_type = std::common_type_t<
+        std::decay_t<std::tuple_element_t<INDS, std::decay_t<TUPLE>>>...>;
+    return std::array<value_type, sizeof...(INDS)>{
+        {value_type(std::get<INDS>(std::forward<TUPLE>(tuple)))...}};
+}
+
+// Turns the result of map_tuple into a table that can be indexed at run time.
+template <typename TUPLE>
+constexpr auto tuple_to_array(TUPLE&& tuple) {
+    return tuple_to_array_impl(
+        std::forward<TUPLE>(tuple),
+        std::make_index_sequence<std::tuple_size_v<std::decay_t<TUPLE>>>{});
+}
+
 }
 
 #endif
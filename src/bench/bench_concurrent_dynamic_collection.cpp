@@ -0,0 +1,103 @@
+#include <lang_utils/iterator.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Times read() plus a full pass over the snapshot from 1..N reader threads,
+// first with the collection left alone and then with a writer calling set()
+// in a loop. Throughput per reader should stay flat as readers are added.
+
+static const size_t element_count = 256;
+static const std::chrono::milliseconds run_time(300);
+
+struct result {
+    double passes_per_sec;
+    double swaps_per_sec;
+};
+
+static result run(size_t reader_count, bool with_writer) {
+    std::vector<int> first(element_count, 1);
+    std::vector<int> second(element_count, 2);
+    lang_utils::concurrent_dynamic_collection<int> dyn(first);
+
+    std::atomic<bool> go{false};
+    std::atomic<bool> done{false};
+    std::atomic<size_t> passes{0};
+    std::atomic<size_t> swaps{0};
+    // keeps the sums alive so the passes aren't optimized away
+    std::atomic<long> sink{0};
+
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < reader_count; ++r) {
+        threads.emplace_back([&]() {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            size_t local_passes = 0;
+            long sum = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                auto snap = dyn.read();
+                for (int i : snap) {
+                    sum += i;
+                }
+                ++local_passes;
+            }
+            passes += local_passes;
+            sink += sum;
+        });
+    }
+    if (with_writer) {
+        threads.emplace_back([&]() {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            size_t local_swaps = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                if (local_swaps % 2 == 0) {
+                    dyn.set(second);
+                } else {
+                    dyn.set(first);
+                }
+                ++local_swaps;
+            }
+            swaps += local_swaps;
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    std::this_thread::sleep_for(run_time);
+    done = true;
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    double secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    return result{double(passes.load()) / secs, double(swaps.load()) / secs};
+}
+
+int main() {
+    size_t max_readers = std::max<size_t>(std::thread::hardware_concurrency(),
+                                          2);
+
+    for (bool with_writer : {false, true}) {
+        std::cout << (with_writer ? "with concurrent set()\n"
+                                  : "without writer\n");
+        for (size_t readers = 1; readers <= max_readers; ++readers) {
+            result r = run(readers, with_writer);
+            std::cout << "  " << readers << " readers: "
+                      << r.passes_per_sec / 1e6 << " M passes/s, "
+                      << r.passes_per_sec / 1e6 / double(readers)
+                      << " M passes/s per reader";
+            if (with_writer) {
+                std::cout << ", " << r.swaps_per_sec / 1e3 << " K sets/s";
+            }
+            std::cout << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <lang_utils/serialize.h>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+// Compares serialize_tuple/deserialize_tuple/tuple_view against encoding the
+// same records through a std::stringstream.
+
+enum class Kind : uint8_t { small, large };
+
+using Record = std::tuple<uint64_t, uint32_t, int16_t, double, Kind>;
+
+static const size_t record_count = 1000000;
+
+template <typename FUNC>
+double time_ns(FUNC &&func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      stop - start).count());
+}
+
+static void report(const char *name, double ns, size_t bytes) {
+    std::cout << name << ": " << ns / record_count << " ns/record, "
+              << double(bytes) / ns * 1e3 << " MB/s\n";
+}
+
+int main() {
+    std::vector<Record> records;
+    records.reserve(record_count);
+    for (size_t i = 0; i < record_count; ++i) {
+        records.emplace_back(i * 7919, uint32_t(i), int16_t(i % 1000),
+                             double(i) * 0.25,
+                             i % 3 == 0 ? Kind::large : Kind::small);
+    }
+
+    constexpr size_t size = lang_utils::serialized_size_v<Record>;
+    std::vector<char> buffer(record_count * size);
+    uint64_t check = 0;
+
+    double ns = time_ns([&]() {
+        lang_utils::serialize_tuples(records.begin(), records.end(),
+                                     buffer.data());
+    });
+    report("serialize_tuples", ns, buffer.size());
+
+    std::vector<Record> decoded(record_count);
+    ns = time_ns([&]() {
+        const char *pos = buffer.data();
+        for (Record &record : decoded) {
+            pos = lang_utils::deserialize_tuple(record, pos);
+        }
+    });
+    check += std::get<0>(decoded.back());
+    report("deserialize_tuple", ns, buffer.size());
+
+    ns = time_ns([&]() {
+        const char *pos = buffer.data();
+        for (size_t i = 0; i < record_count; ++i, pos += size) {
+            check += lang_utils::tuple_view<Record>(pos).get<1>();
+        }
+    });
+    report("tuple_view one field", ns, buffer.size());
+
+    std::stringstream stream;
+    ns = time_ns([&]() {
+        for (const Record &record : records) {
+            lang_utils::foreach_tuple([&stream](const auto &field) {
+                stream.write(reinterpret_cast<const char*>(&field),
+                             sizeof(field));
+            }, record);
+        }
+    });
+    report("stringstream write", ns, buffer.size());
+
+    ns = time_ns([&]() {
+        for (Record &record : decoded) {
+            lang_utils::foreach_tuple([&stream](auto &field) {
+                stream.read(reinterpret_cast<char*>(&field), sizeof(field));
+            }, record);
+        }
+    });
+    check += std::get<0>(decoded.back());
+    report("stringstream read", ns, buffer.size());
+
+    std::stringstream text;
+    ns = time_ns([&]() {
+        for (const Record &record : records) {
+            text << std::get<0>(record) << ' ' << std::get<1>(record) << ' '
+                 << std::get<2>(record) << ' ' << std::get<3>(record) << ' '
+                 << int(std::get<4>(record)) << '\n';
+        }
+    });
+    report("stringstream text <<", ns, buffer.size());
+
+    ns = time_ns([&]() {
+        for (Record &record : decoded) {
+            int kind;
+            text >> std::get<0>(record) >> std::get<1>(record)
+                 >> std::get<2>(record) >> std::get<3>(record) >> kind;
+            std::get<4>(record) = Kind(kind);
+        }
+    });
+    check += std::get<0>(decoded.back());
+    report("stringstream text >>", ns, buffer.size());
+
+    std::cout << "checksum " << check << "\n";
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <lang_utils/slice_algorithm.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Compares the slice kernels at each simd_level against the std algorithms
+// they replace, on floating point and integer data that stays in cache.
+
+static const size_t element_count = 1 << 16;
+static const size_t repeats = 2000;
+
+static const lang_utils::simd_level levels[] = {
+    lang_utils::simd_level::scalar,
+    lang_utils::simd_level::sse2,
+    lang_utils::simd_level::avx2
+};
+
+static const char *level_names[] = {"scalar", "sse2", "avx2"};
+
+// keeps results alive so the loops aren't optimized away
+static volatile double sink;
+
+template <typename FUNC>
+void time_op(const std::string &name, FUNC &&func) {
+    auto start = std::chrono::steady_clock::now();
+    double total = 0;
+    for (size_t r = 0; r < repeats; ++r) {
+        total += double(func());
+    }
+    auto stop = std::chrono::steady_clock::now();
+    sink = total;
+    double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           stop - start).count());
+    std::cout << "  " << name << ": "
+              << ns / double(repeats * element_count) << " ns/element\n";
+}
+
+template <typename T>
+void bench(const char *type_name) {
+    using namespace lang_utils;
+
+    std::vector<T> a(element_count);
+    std::vector<T> b(element_count);
+    for (size_t i = 0; i < element_count; ++i) {
+        a[i] = T(i % 100);
+        b[i] = T(i % 7);
+    }
+    // needle near the end so find scans almost everything
+    a[element_count - 3] = T(-1);
+
+    auto sa = make_slice(a.begin(), a.end());
+    auto sb = make_slice(b.begin(), b.end());
+
+    std::cout << type_name << "\n";
+
+    time_op("std::accumulate", [&]() {
+        return std::accumulate(a.begin(), a.end(), T(0));
+    });
+    time_op("std::inner_product", [&]() {
+        return std::inner_product(a.begin(), a.end(), b.begin(), T(0));
+    });
+    time_op("std::min_element", [&]() {
+        return *std::min_element(a.begin(), a.end());
+    });
+    time_op("std::count", [&]() {
+        return std::count(a.begin(), a.end(), T(-1));
+    });
+    time_op("std::find", [&]() {
+        return std::find(a.begin(), a.end(), T(-1)) - a.begin();
+    });
+
+    for (size_t l = 0; l < 3; ++l) {
+        simd_level level = levels[l];
+        if (std::min(level, detected_simd_level()) != level) {
+            continue;
+        }
+        std::string suffix = std::string(" ") + level_names[l];
+        time_op("slice_sum" + suffix, [&]() { return slice_sum(sa, level); });
+        time_op("slice_dot" + suffix, [&]() {
+            return slice_dot(sa, sb, level);
+        });
+        time_op("slice_min" + suffix, [&]() { return slice_min(sa, level); });
+        time_op("slice_count" + suffix, [&]() {
+            return slice_count(sa, T(-1), level);
+        });
+        time_op("slice_find" + suffix, [&]() {
+            return slice_find(sa, T(-1), level) - a.begin();
+        });
+    }
+}
+
+int main() {
+    bench<float>("float");
+    bench<double>("double");
+    bench<int8_t>("int8_t");
+    bench<int32_t>("int32_t");
+    bench<int64_t>("int64_t");
+    return 0;
+}
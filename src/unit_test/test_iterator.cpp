@@ -5,6 +5,8 @@
 
 #include <vector>
 #include <list>
+#include <atomic>
+#include <thread>
 
 using namespace lang_utils;
 
@@ -85,6 +87,85 @@ BOOST_AUTO_TEST_CASE(test_dynamic_collection) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_concurrent_dynamic_collection) {
+    std::vector<int> one {1, 3, 5};
+    std::list<int> two {2, 4, 6};
+
+    concurrent_dynamic_collection<int> dyn(one);
+
+    auto iter1 = one.begin();
+    for (int i : dyn.read()) {
+        BOOST_REQUIRE_EQUAL(i, *iter1);
+        ++iter1;
+    }
+
+    dyn.set(two);
+    auto iter2 = two.begin();
+    for (int i : dyn.read()) {
+        BOOST_REQUIRE_EQUAL(i, *iter2);
+        ++iter2;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_concurrent_dynamic_collection_stress) {
+    std::vector<int> evens {0, 2, 4, 6, 8, 10, 12, 14};
+    std::list<int> odds {1, 3, 5, 7, 9, 11, 13, 15};
+
+    concurrent_dynamic_collection<int> dyn(evens);
+    std::atomic<bool> done{false};
+    std::atomic<int> bad{0};
+    std::atomic<int> started{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&]() {
+            bool first = true;
+            while (!done.load()) {
+                auto snap = dyn.read();
+                int count = 0;
+                int parity = -1;
+                for (int i : snap) {
+                    if (parity == -1) {
+                        parity = i % 2;
+                    }
+                    if (i % 2 != parity || i / 2 != count) {
+                        ++bad;
+                    }
+                    ++count;
+                }
+                if (count != 8) {
+                    ++bad;
+                }
+                if (first) {
+                    ++started;
+                    first = false;
+                }
+            }
+        });
+    }
+
+    // every reader is mid loop before the swaps start, so they overlap
+    while (started.load() < 4) {
+        std::this_thread::yield();
+    }
+    BOOST_REQUIRE_EQUAL(started.load(), 4);
+
+    for (int i = 0; i < 100; ++i) {
+        if (i % 2 == 0) {
+            dyn.set(odds);
+        } else {
+            dyn.set(evens);
+        }
+    }
+    done = true;
+
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    BOOST_REQUIRE_EQUAL(bad.load(), 0);
+}
+
 BOOST_AUTO_TEST_CASE(test_slice) {
     std::vector<int> data {1, 2, 3, 4, 5, 6, 7, 8};
 
@@ -99,3 +180,63 @@ BOOST_AUTO_TEST_CASE(test_slice) {
 
     BOOST_CHECK_EQUAL(expected, 8);
 }
+
+BOOST_AUTO_TEST_CASE(test_merge_range) {
+    std::vector<int> one {1, 4, 7, 10};
+    std::list<int> two {2, 5, 8};
+    std::vector<int> three {0, 3, 6, 9, 11, 12};
+    std::vector<int> empty;
+
+    dynamic_collection<int> dyn(two);
+
+    merge_range<int> merged;
+    merged.add(one);
+    merged.add(dyn);
+    merged.add(make_slice(three.begin(), three.end()));
+    merged.add(empty);
+
+    int expected = 0;
+    for (int found : merged) {
+        BOOST_CHECK_EQUAL(expected, found);
+        ++expected;
+    }
+
+    BOOST_CHECK_EQUAL(expected, 13);
+}
+
+BOOST_AUTO_TEST_CASE(test_merge_range_many) {
+    std::vector<std::vector<int>> runs(37);
+    for (int i = 0; i < 1000; ++i) {
+        runs[(i * 7) % runs.size()].push_back(1000 - i);
+    }
+
+    merge_range<int, std::greater<int>> merged;
+    for (auto &run : runs) {
+        merged.add(run);
+    }
+
+    int expected = 1000;
+    for (int found : merged) {
+        BOOST_REQUIRE_EQUAL(expected, found);
+        --expected;
+    }
+
+    BOOST_CHECK_EQUAL(expected, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_make_merge_range) {
+    std::vector<int> one {5, 3};
+    std::list<int> two {6, 4, 1};
+
+    auto merged = make_merge_range<int>(std::greater<int>(), one, two);
+
+    std::vector<int> found(merged.begin(), merged.end());
+    BOOST_CHECK(found == std::vector<int>({6, 5, 4, 3, 1}));
+
+    merge_range<int> none;
+    BOOST_CHECK(none.begin() == none.end());
+}
+
+static_assert(is_range_view<slice<std::vector<int>::iterator>>::value);
+static_assert(is_range_view<dynamic_collection<int>>::value);
+static_assert(!is_range_view<std::vector<int>>::value);
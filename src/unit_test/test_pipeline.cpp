@@ -0,0 +1,105 @@
+#include <lang_utils/pipeline.h>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#define BOOST_TEST_MODULE test_pipeline
+#include <boost/test/unit_test.hpp>
+
+struct decode {
+    int operator()(const std::string &s) { return std::stoi(s); }
+};
+
+struct transform {
+    double operator()(int i) { return i * 1.5; }
+};
+
+struct encode {
+    std::string operator()(double d) { return std::to_string(int(d * 2)); }
+};
+
+using Stages = lang_utils::pipeline<decode, transform, encode>;
+
+static_assert(std::is_same<Stages::output_type<std::string>,
+                           std::string>::value);
+static_assert(std::is_same<lang_utils::stage_chain<std::string, decode,
+                                                   transform>::types,
+                           std::tuple<std::string, int, double>>::value);
+
+BOOST_AUTO_TEST_CASE(test_spsc_ring) {
+    lang_utils::spsc_ring<int> ring(3);
+    std::atomic<bool> abort{false};
+
+    BOOST_REQUIRE_EQUAL(ring.capacity(), 4);
+
+    std::vector<int> items {1, 2, 3};
+    BOOST_REQUIRE(ring.push_batch(items, abort));
+
+    std::vector<int> popped;
+    BOOST_REQUIRE(ring.pop_batch(popped, 2, abort));
+    BOOST_REQUIRE(popped == std::vector<int>({1, 2}));
+
+    items = {4, 5, 6};
+    BOOST_REQUIRE(ring.push_batch(items, abort));
+    ring.close();
+
+    BOOST_REQUIRE(ring.pop_batch(popped, 8, abort));
+    BOOST_REQUIRE(popped == std::vector<int>({3, 4, 5, 6}));
+    BOOST_REQUIRE(!ring.pop_batch(popped, 8, abort));
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline) {
+    std::vector<std::string> input;
+    for (int i = 0; i < 10000; ++i) {
+        input.push_back(std::to_string(i));
+    }
+
+    // small ring and odd batch size to exercise backpressure and wrapping
+    lang_utils::pipeline stages(std::make_tuple(decode(), transform(),
+                                                encode()), 16, 5);
+
+    std::vector<std::string> output;
+    stages.run(input.begin(), input.end(), std::back_inserter(output));
+
+    BOOST_REQUIRE_EQUAL(output.size(), input.size());
+    for (int i = 0; i < 10000; ++i) {
+        BOOST_REQUIRE_EQUAL(output[i], std::to_string(i * 3));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_lambdas) {
+    std::vector<int> input {1, 2, 3, 4};
+    int calls = 0;
+
+    auto stages = lang_utils::make_pipeline(std::make_tuple(
+        [&calls](int i) { ++calls; return i * i; },
+        [](int i) { return std::to_string(i); }));
+
+    std::vector<std::string> output;
+    stages.run(input.begin(), input.end(), std::back_inserter(output));
+
+    BOOST_REQUIRE_EQUAL(calls, 4);
+    BOOST_REQUIRE(output == std::vector<std::string>({"1", "4", "9", "16"}));
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_exception) {
+    std::vector<int> input(1000, 1);
+    input[500] = 0;
+
+    auto stages = lang_utils::make_pipeline(std::make_tuple(
+        [](int i) {
+            if (i == 0) {
+                throw std::runtime_error("zero");
+            }
+            return i;
+        },
+        [](int i) { return i + 1; }), 8, 4);
+
+    std::vector<int> output;
+    BOOST_REQUIRE_THROW(
+        stages.run(input.begin(), input.end(), std::back_inserter(output)),
+        std::runtime_error);
+    BOOST_REQUIRE(output.size() <= 500);
+}
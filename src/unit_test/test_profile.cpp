@@ -0,0 +1,114 @@
+#include <lang_utils/profile.h>
+#include <lang_utils/tuple.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+#define BOOST_TEST_MODULE test_profile
+#include <boost/test/unit_test.hpp>
+
+// advances 100ns every time it is read
+struct tick_clock {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<tick_clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() {
+        static rep ticks = 0;
+        ticks += 100;
+        return time_point(duration(ticks));
+    }
+};
+
+struct indexed {
+    template <size_t POS, typename ARG>
+    void operator()(ARG &&a) {
+        m_ss << POS << ":" << a << " ";
+    }
+
+    std::stringstream m_ss;
+};
+
+BOOST_AUTO_TEST_CASE(test_profiled_foreach_tuple) {
+    lang_utils::tuple_profiler<3, tick_clock> profiler;
+    std::stringstream ss;
+
+    auto stringer = [&ss](auto a, auto b) {
+        ss << a << " and " << b << " then ";
+    };
+
+    auto tup1 = std::make_tuple(1, 'a', 4);
+    auto tup2 = std::make_tuple(5.5, "asdf", 2);
+
+    lang_utils::foreach_tuple(lang_utils::make_profiled(profiler, stringer),
+                              tup1, tup2);
+    lang_utils::foreach_tuple(lang_utils::make_profiled(profiler, stringer),
+                              tup1, tup2);
+
+    BOOST_REQUIRE_EQUAL(ss.str(), "1 and 5.5 then a and asdf then 4 and 2 then "
+                                  "1 and 5.5 then a and asdf then 4 and 2 then ");
+
+    for (size_t i = 0; i < profiler.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(profiler[i].count, 2);
+        BOOST_REQUIRE_EQUAL(profiler[i].total_ns, 200);
+        BOOST_REQUIRE_EQUAL(profiler[i].max_ns, 100);
+        BOOST_REQUIRE_EQUAL(profiler[i].percentile_ns(0.5), 128);
+    }
+    BOOST_REQUIRE_EQUAL(profiler[0].type_name(), "int");
+    BOOST_REQUIRE_EQUAL(profiler[1].type_name(), "char");
+
+    std::stringstream report;
+    profiler.report(report);
+    BOOST_REQUIRE(report.str().find("1 char: calls 2 total_ns 200")
+                  != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_profiled_foreach_tuple_p) {
+    lang_utils::tuple_profiler<2, tick_clock> profiler;
+    indexed stringer;
+    auto tup = std::make_tuple(3, 'b');
+
+    lang_utils::foreach_tuple_p(lang_utils::make_profiled(profiler, stringer),
+                                tup);
+
+    BOOST_REQUIRE_EQUAL(stringer.m_ss.str(), "0:3 1:b ");
+    BOOST_REQUIRE_EQUAL(profiler[0].count, 1);
+    BOOST_REQUIRE_EQUAL(profiler[1].count, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_profiled_map_reduce_tuple) {
+    lang_utils::tuple_profiler<3, tick_clock> profiler;
+
+    auto tup = std::make_tuple(1, 2.5, 3);
+
+    auto doubled = lang_utils::map_tuple_i(
+        lang_utils::make_profiled(profiler, [](size_t i, auto a) {
+            return a * 2 + i;
+        }), tup);
+
+    BOOST_REQUIRE(doubled == std::make_tuple(2, 6.0, 8));
+
+    double sum = lang_utils::reduce_tuple(
+        lang_utils::make_profiled(profiler, [](double accum, auto a) {
+            return accum + a;
+        }), 0.0, tup);
+
+    BOOST_REQUIRE_EQUAL(sum, 6.5);
+    BOOST_REQUIRE_EQUAL(profiler[1].count, 2);
+    BOOST_REQUIRE_EQUAL(profiler[1].type_name(), "double");
+}
+
+BOOST_AUTO_TEST_CASE(test_null_profiler) {
+    lang_utils::null_profiler profiler;
+
+    auto tup = std::make_tuple(1, 2, 3);
+    int sum = lang_utils::reduce_tuple(
+        lang_utils::make_profiled(profiler, [](int accum, int a) {
+            return accum + a;
+        }), 0, tup);
+
+    BOOST_REQUIRE_EQUAL(sum, 6);
+}
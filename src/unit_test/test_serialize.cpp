@@ -0,0 +1,119 @@
+#include <lang_utils/serialize.h>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#define BOOST_TEST_MODULE test_serialize
+#include <boost/test/unit_test.hpp>
+
+enum class Color : uint8_t { red = 1, green = 2 };
+
+using Record = std::tuple<uint32_t, Color, int16_t, double>;
+
+enum Plain { plain_value };
+enum Fixed : int16_t { fixed_value };
+enum WideChar : wchar_t { wide_value };
+
+static_assert(lang_utils::is_serializable_field<int64_t>::value);
+static_assert(lang_utils::is_serializable_field<Color>::value);
+static_assert(lang_utils::is_serializable_field<Fixed>::value);
+static_assert(lang_utils::is_serializable_field<bool>::value);
+static_assert(!lang_utils::is_serializable_field<long double>::value);
+static_assert(!lang_utils::is_serializable_field<char>::value);
+static_assert(!lang_utils::is_serializable_field<wchar_t>::value);
+static_assert(!lang_utils::is_serializable_field<Plain>::value);
+static_assert(!lang_utils::is_serializable_field<WideChar>::value);
+
+BOOST_AUTO_TEST_CASE(test_serialized_layout) {
+    BOOST_REQUIRE_EQUAL(lang_utils::serialized_size_v<Record>, 15);
+    BOOST_REQUIRE_EQUAL((lang_utils::serialized_offset_v<0, Record>), 0);
+    BOOST_REQUIRE_EQUAL((lang_utils::serialized_offset_v<1, Record>), 4);
+    BOOST_REQUIRE_EQUAL((lang_utils::serialized_offset_v<2, Record>), 5);
+    BOOST_REQUIRE_EQUAL((lang_utils::serialized_offset_v<3, Record>), 7);
+}
+
+BOOST_AUTO_TEST_CASE(test_serialize_little_endian) {
+    std::tuple<uint32_t, int16_t> tup(0x04030201, -2);
+    unsigned char buf[6];
+
+    char *end = lang_utils::serialize_tuple(tup, reinterpret_cast<char*>(buf));
+
+    BOOST_REQUIRE(end == reinterpret_cast<char*>(buf) + 6);
+    BOOST_REQUIRE_EQUAL(buf[0], 0x01);
+    BOOST_REQUIRE_EQUAL(buf[1], 0x02);
+    BOOST_REQUIRE_EQUAL(buf[2], 0x03);
+    BOOST_REQUIRE_EQUAL(buf[3], 0x04);
+    BOOST_REQUIRE_EQUAL(buf[4], 0xfe);
+    BOOST_REQUIRE_EQUAL(buf[5], 0xff);
+}
+
+BOOST_AUTO_TEST_CASE(test_serialize_round_trip) {
+    Record in(42, Color::green, -7, 3.25);
+    char buf[lang_utils::serialized_size_v<Record>];
+
+    lang_utils::serialize_tuple(in, buf);
+
+    Record out;
+    const char *end = lang_utils::deserialize_tuple(out, buf);
+
+    BOOST_REQUIRE(end == buf + sizeof(buf));
+    BOOST_REQUIRE(in == out);
+    BOOST_REQUIRE(in == lang_utils::deserialize_tuple<Record>(buf));
+}
+
+BOOST_AUTO_TEST_CASE(test_serialize_stream) {
+    std::vector<Record> records {
+        Record(1, Color::red, 10, 0.5),
+        Record(2, Color::green, 20, 1.5),
+        Record(3, Color::red, 30, 2.5)
+    };
+    std::vector<char> buf(records.size() * lang_utils::serialized_size_v<Record>);
+
+    char *end = lang_utils::serialize_tuples(records.begin(), records.end(),
+                                             buf.data());
+    BOOST_REQUIRE(end == buf.data() + buf.size());
+
+    const char *pos = buf.data();
+    for (const Record &expected : records) {
+        Record found;
+        pos = lang_utils::deserialize_tuple(found, pos);
+        BOOST_REQUIRE(expected == found);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_tuple_view) {
+    Record first(7, Color::green, -3, 9.75);
+    Record second(8, Color::red, 4, -1.0);
+    // offset by one so the view has to cope with unaligned fields
+    char buf[1 + 2 * lang_utils::serialized_size_v<Record>];
+
+    lang_utils::serialize_tuple(second,
+        lang_utils::serialize_tuple(first, buf + 1));
+
+    lang_utils::tuple_view<Record> view(buf + 1);
+    BOOST_REQUIRE_EQUAL(view.get<0>(), 7);
+    BOOST_REQUIRE(view.get<1>() == Color::green);
+    BOOST_REQUIRE_EQUAL(view.get<2>(), -3);
+    BOOST_REQUIRE_EQUAL(lang_utils::get<3>(view), 9.75);
+
+    lang_utils::tuple_view<Record> next(view.next());
+    BOOST_REQUIRE_EQUAL(next.get<0>(), 8);
+    BOOST_REQUIRE(next.materialize() == second);
+}
+
+BOOST_AUTO_TEST_CASE(test_serialize_bool) {
+    using Flags = std::tuple<bool, Fixed, bool>;
+    BOOST_REQUIRE_EQUAL(lang_utils::serialized_size_v<Flags>, 4);
+
+    char buf[4];
+    lang_utils::serialize_tuple(Flags(true, fixed_value, false), buf);
+    BOOST_REQUIRE_EQUAL(buf[0], 1);
+    BOOST_REQUIRE_EQUAL(buf[3], 0);
+
+    // any non-zero byte reads back as true
+    buf[0] = 0x7f;
+    lang_utils::tuple_view<Flags> view(buf);
+    BOOST_REQUIRE(view.get<0>());
+    BOOST_REQUIRE(!view.get<2>());
+    BOOST_REQUIRE(view.get<1>() == fixed_value);
+}
@@ -0,0 +1,261 @@
+#include <lang_utils/slice_algorithm.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <vector>
+
+#define BOOST_TEST_MODULE test_slice_algorithm
+#include <boost/test/unit_test.hpp>
+
+using namespace lang_utils;
+
+static const simd_level levels[] = {
+    simd_level::scalar, simd_level::sse2, simd_level::avx2
+};
+
+template <typename T>
+std::vector<T> awkward_values(size_t size) {
+    // wide dynamic range so any change in summation order changes the bits
+    std::vector<T> values;
+    for (size_t i = 0; i < size; ++i) {
+        T sign = (i % 3 == 0) ? T(-1) : T(1);
+        values.push_back(sign * std::ldexp(T(1) + T(i % 7) / T(10),
+                                           int(i % 40) - 20));
+    }
+    return values;
+}
+
+template <typename T>
+bool same_bits(T a, T b) {
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+static_assert(is_simd_slice<std::vector<float>::iterator>::value);
+static_assert(is_simd_slice<const double*>::value);
+static_assert(is_simd_slice<std::vector<int>::iterator>::value);
+static_assert(is_simd_slice<const uint8_t*>::value);
+static_assert(!is_simd_slice<std::list<float>::iterator>::value);
+static_assert(!is_simd_slice<std::vector<long double>::iterator>::value);
+static_assert(!is_simd_slice<const bool*>::value);
+static_assert(!is_contiguous_iterator<std::vector<bool>::iterator>::value);
+
+template <typename T>
+void check_exact_sums() {
+    for (size_t size : {0, 1, 7, 16, 33, 100, 1023}) {
+        std::vector<T> a = awkward_values<T>(size);
+        std::vector<T> b = awkward_values<T>(size + 5);
+        b.erase(b.begin(), b.begin() + 5);
+
+        auto sa = make_slice(a.begin(), a.end());
+        auto sb = make_slice(b.begin(), b.end());
+
+        T sum = slice_sum(sa, simd_level::scalar);
+        T dot = slice_dot(sa, sb, simd_level::scalar);
+        for (simd_level level : levels) {
+            BOOST_REQUIRE(same_bits(sum, slice_sum(sa, level)));
+            BOOST_REQUIRE(same_bits(dot, slice_dot(sa, sb, level)));
+        }
+
+        // close to the naive result
+        T naive = 0;
+        for (T v : a) {
+            naive += v;
+        }
+        BOOST_REQUIRE(std::abs(sum - naive) <= 1e-3 * (std::abs(naive) + 1));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_slice_sum_dot_exact) {
+    check_exact_sums<float>();
+    check_exact_sums<double>();
+}
+
+BOOST_AUTO_TEST_CASE(test_slice_sum_values) {
+    std::vector<double> data {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    std::list<double> list(data.begin(), data.end());
+    std::vector<int> ints {1, 2, 3};
+
+    for (simd_level level : levels) {
+        BOOST_REQUIRE_EQUAL(slice_sum(make_slice(data.begin() + 2,
+                                                 data.end()), level), 52);
+        BOOST_REQUIRE_EQUAL(slice_dot(make_slice(data.begin(), data.end()),
+                                      make_slice(list.begin(), list.end()),
+                                      level), 385);
+    }
+    BOOST_REQUIRE_EQUAL(slice_sum(make_slice(list.begin(), list.end())), 55);
+    BOOST_REQUIRE_EQUAL(slice_sum(make_slice(ints.begin(), ints.end())), 6);
+}
+
+template <typename T>
+void check_nan_min_max() {
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    // the NaN shares a lane with both extremes
+    std::vector<T> data(40, T(1));
+    data[1] = nan;
+    data[17] = T(-100);
+    data[33] = T(100);
+    data[39] = nan;
+    auto s = make_slice(data.begin(), data.end());
+
+    for (simd_level level : levels) {
+        BOOST_REQUIRE_EQUAL(slice_min(s, level),
+                            *std::min_element(data.begin(), data.end()));
+        BOOST_REQUIRE_EQUAL(slice_min(s, level), T(-100));
+        BOOST_REQUIRE_EQUAL(slice_max(s, level), T(100));
+    }
+
+    // only a leading NaN is returned
+    data[0] = nan;
+    for (simd_level level : levels) {
+        BOOST_REQUIRE(std::isnan(slice_min(s, level)));
+        BOOST_REQUIRE(std::isnan(slice_max(s, level)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_slice_min_max) {
+    std::vector<float> data = awkward_values<float>(301);
+    data[123] = -1e30f;
+    data[250] = 1e30f;
+
+    for (size_t size : {1, 5, 16, 130, 301}) {
+        auto s = make_slice(data.begin(), data.begin() + size);
+        float expected_min = *std::min_element(s.begin(), s.end());
+        float expected_max = *std::max_element(s.begin(), s.end());
+        for (simd_level level : levels) {
+            BOOST_REQUIRE_EQUAL(slice_min(s, level), expected_min);
+            BOOST_REQUIRE_EQUAL(slice_max(s, level), expected_max);
+        }
+    }
+
+    check_nan_min_max<float>();
+    check_nan_min_max<double>();
+
+    std::list<int> list {3, -4, 9};
+    BOOST_REQUIRE_EQUAL(slice_min(make_slice(list.begin(), list.end())), -4);
+    BOOST_REQUIRE_EQUAL(slice_max(make_slice(list.begin(), list.end())), 9);
+}
+
+BOOST_AUTO_TEST_CASE(test_slice_count_find) {
+    std::vector<double> data(1000, 1.5);
+    data[3] = 2.0;
+    data[517] = 2.0;
+    data[999] = 2.0;
+    data[700] = std::numeric_limits<double>::quiet_NaN();
+
+    auto s = make_slice(data.begin(), data.end());
+    auto tail = make_slice(data.begin() + 4, data.end());
+
+    for (simd_level level : levels) {
+        BOOST_REQUIRE_EQUAL(slice_count(s, 2.0, level), 3);
+        BOOST_REQUIRE_EQUAL(slice_count(s, 1.5, level), 996);
+        BOOST_REQUIRE_EQUAL(slice_count(
+            s, std::numeric_limits<double>::quiet_NaN(), level), 0);
+
+        BOOST_REQUIRE(slice_find(s, 2.0, level) == data.begin() + 3);
+        BOOST_REQUIRE(slice_find(tail, 2.0, level) == data.begin() + 517);
+        BOOST_REQUIRE(slice_find(s, 7.0, level) == data.end());
+    }
+
+    std::vector<float> small {1, 2, 3};
+    BOOST_REQUIRE(slice_find(make_slice(small.begin(), small.end()), 3) ==
+                  small.begin() + 2);
+
+    std::list<int> list {3, -4, 9, -4};
+    BOOST_REQUIRE_EQUAL(slice_count(make_slice(list.begin(), list.end()), -4),
+                        2);
+}
+
+template <typename T>
+void check_integers() {
+    // long enough that narrow lane counters in slice_count have to flush
+    std::vector<T> data;
+    for (size_t i = 0; i < 20011; ++i) {
+        data.push_back(T(int(i * 37 % 101) - 50));
+    }
+    data[9000] = T(77);
+    data[15000] = T(77);
+    std::vector<T> other(data.rbegin(), data.rend());
+    // the std algorithms over a list are the reference
+    std::list<T> list(data.begin(), data.end());
+    std::list<T> other_list(other.begin(), other.end());
+
+    auto s = make_slice(data.begin(), data.end());
+    auto so = make_slice(other.begin(), other.end());
+    auto ls = make_slice(list.begin(), list.end());
+    auto lso = make_slice(other_list.begin(), other_list.end());
+
+    std::vector<T> same(20000, T(5));
+    auto ss = make_slice(same.begin(), same.end());
+
+    for (simd_level level : levels) {
+        BOOST_REQUIRE(slice_sum(s, level) == slice_sum(ls));
+        BOOST_REQUIRE(slice_dot(s, so, level) == slice_dot(ls, lso));
+        BOOST_REQUIRE(slice_min(s, level) == slice_min(ls));
+        BOOST_REQUIRE(slice_max(s, level) == slice_max(ls));
+        BOOST_REQUIRE_EQUAL(slice_count(s, T(77), level), 2);
+        BOOST_REQUIRE_EQUAL(slice_count(s, T(3), level), slice_count(ls, T(3)));
+        BOOST_REQUIRE_EQUAL(slice_count(ss, T(5), level), same.size());
+        BOOST_REQUIRE(slice_find(s, T(77), level) == data.begin() + 9000);
+        BOOST_REQUIRE(slice_find(s, T(99), level) == data.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_slice_integers) {
+    check_integers<int8_t>();
+    check_integers<uint8_t>();
+    check_integers<int16_t>();
+    check_integers<uint16_t>();
+    check_integers<int32_t>();
+    check_integers<uint32_t>();
+    check_integers<int64_t>();
+    check_integers<uint64_t>();
+
+    std::vector<uint8_t> bytes(100, 255);
+    std::vector<uint32_t> words(100, 0xffffffff);
+    std::vector<int> ints(100, 2);
+    auto sb = make_slice(bytes.begin(), bytes.end());
+    auto sw = make_slice(words.begin(), words.end());
+    auto si = make_slice(ints.begin(), ints.end());
+
+    for (simd_level level : levels) {
+        // compared in the common type, like std::count
+        BOOST_REQUIRE_EQUAL(slice_count(sb, -1, level), 0);
+        BOOST_REQUIRE_EQUAL(slice_count(sb, 255 + 256, level), 0);
+        BOOST_REQUIRE_EQUAL(slice_count(sw, -1, level),
+                            size_t(std::count(words.begin(), words.end(), -1)));
+        BOOST_REQUIRE_EQUAL(slice_count(si, 2.0, level), 100);
+        BOOST_REQUIRE_EQUAL(slice_count(si, 2.5, level), 0);
+        BOOST_REQUIRE(slice_find(si, 1e300, level) == ints.end());
+        BOOST_REQUIRE(slice_find(si, std::numeric_limits<double>::quiet_NaN(),
+                                 level) == ints.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_slice_count_find_mixed_types) {
+    std::vector<float> data(100, 0.1f);
+    data[40] = 0.5f;
+    std::list<float> list(data.begin(), data.end());
+    auto s = make_slice(data.begin(), data.end());
+    auto ls = make_slice(list.begin(), list.end());
+
+    for (simd_level level : levels) {
+        // 0.1 isn't a float, so no element equals it as a double
+        BOOST_REQUIRE_EQUAL(slice_count(s, 0.1, level),
+                            size_t(std::count(data.begin(), data.end(), 0.1)));
+        BOOST_REQUIRE_EQUAL(slice_count(s, 0.1, level), 0);
+        BOOST_REQUIRE(slice_find(s, 0.1, level) == data.end());
+
+        // 0.5 is exact in both
+        BOOST_REQUIRE_EQUAL(slice_count(s, 0.5, level), 1);
+        BOOST_REQUIRE(slice_find(s, 0.5, level) == data.begin() + 40);
+        BOOST_REQUIRE(slice_find(s, 1e300, level) == data.end());
+        BOOST_REQUIRE_EQUAL(slice_count(
+            s, std::numeric_limits<double>::quiet_NaN(), level), 0);
+    }
+
+    BOOST_REQUIRE_EQUAL(slice_count(ls, 0.1), 0);
+    BOOST_REQUIRE(slice_find(ls, 0.1) == list.end());
+    BOOST_REQUIRE_EQUAL(slice_count(ls, 0.1f), 99);
+}
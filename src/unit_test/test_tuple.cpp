@@ -1,4 +1,5 @@
 #include <lang_utils/tuple.h>
+#include <array>
 #include <tuple>
 #include <vector>
 #include <sstream>
@@ -122,3 +123,50 @@ BOOST_AUTO_TEST_CASE(test_reduce_tuple) {
 
     BOOST_REQUIRE_EQUAL(result, "1 and 5.5 then a and asdf then 4 and 2 then ");
 }
+
+constexpr int sum_foreach() {
+    int sum = 0;
+    auto tup = std::make_tuple(1, 2, 3);
+    lang_utils::foreach_tuple([&sum](int a) { sum += a; }, tup);
+    return sum;
+}
+
+struct weighted {
+    template <size_t POS>
+    constexpr int operator()(int a) const { return int(POS) * a; }
+};
+
+constexpr int sum_weighted() {
+    int sum = 0;
+    std::tuple<int, int, int> tup(4, 5, 6);
+    weighted weigh;
+    lang_utils::foreach_tuple_i([&sum, &weigh](size_t i, int a) {
+        sum += int(i) * a;
+    }, tup);
+    auto weights = lang_utils::map_tuple_p(weigh, tup);
+    return sum + std::get<2>(weights);
+}
+
+constexpr std::array<int, 4> squares {{1, 2, 3, 4}};
+
+constexpr auto squared_table = lang_utils::tuple_to_array(
+    lang_utils::map_tuple([](int a) { return a * a; }, squares));
+
+constexpr auto scaled = lang_utils::map_tuple_i(
+    [](size_t i, int a, double b) { return a * b + double(i); },
+    squares, std::array<double, 4>{{0.5, 1.5, 2.5, 3.5}});
+
+static_assert(sum_foreach() == 6);
+static_assert(sum_weighted() == 5 + 12 + 12);
+static_assert(squared_table[0] == 1 && squared_table[3] == 16);
+static_assert(std::get<3>(scaled) == 17.0);
+static_assert(lang_utils::reduce_tuple([](int accum, int a, int b) {
+                  return accum + a * b;
+              }, 0, squares, squares) == 30);
+static_assert(std::get<1>(lang_utils::slice_tuples<1>(squares, squares)) == 2);
+
+BOOST_AUTO_TEST_CASE(test_constexpr_tuple) {
+    BOOST_REQUIRE_EQUAL(squared_table.size(), 4);
+    BOOST_REQUIRE_EQUAL(squared_table[2], 9);
+    BOOST_REQUIRE_EQUAL(sum_foreach(), 6);
+}